@@ -18,6 +18,49 @@
 #define NDEBUG
 #endif
 
+// Logging below this level is removed at compiletime, see Loglevel_t.
+#if !defined(LOG_MINLEVEL)
+    #if defined(NDEBUG)
+        #define LOG_MINLEVEL 2
+    #else
+        #define LOG_MINLEVEL 0
+    #endif
+#endif
+
+// Messages per second and burst-size allowed from a single log-callsite.
+#if !defined(LOG_RATELIMIT_PERSECOND)
+    #define LOG_RATELIMIT_PERSECOND 5
+#endif
+#if !defined(LOG_RATELIMIT_BURST)
+    #define LOG_RATELIMIT_BURST 20
+#endif
+
+// Bytes of released Bytebuffer storage each thread keeps for reuse, 0 disables the pool.
+#if !defined(BYTEBUFFER_POOL_LIMIT)
+    #define BYTEBUFFER_POOL_LIMIT (1024 * 1024)
+#endif
+
+// Without SIMD, patterns with a wildcard-free run of at least this many bytes are scanned with Horspool.
+#if !defined(PATTERN_HORSPOOL_MINIMUM)
+    #define PATTERN_HORSPOOL_MINIMUM 16
+#endif
+
+// Threads per pattern scan, 0 selects the hardware concurrency. Scans from DllMain should stay at 1.
+#if !defined(PATTERN_THREADCOUNT)
+    #define PATTERN_THREADCOUNT 1
+#endif
+
+// Profilehook() counts calls and cycles per hook when set, the totals are logged every interval (seconds, 0 only on Dump()).
+#if !defined(HOOKING_PROFILE)
+    #define HOOKING_PROFILE 0
+#endif
+#if !defined(HOOKING_PROFILE_INTERVAL)
+    #define HOOKING_PROFILE_INTERVAL 60
+#endif
+#if !defined(HOOKING_PROFILE_SITES)
+    #define HOOKING_PROFILE_SITES 256
+#endif
+
 // Platform identification.
 #if defined(_MSC_VER)
     #define EXPORT_ATTR __declspec(dllexport)
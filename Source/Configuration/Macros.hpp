@@ -8,19 +8,28 @@
 
 #pragma once
 
+// Leveled logging, messages below LOG_MINLEVEL are never evaluated.
+#define Logleveled(Level, Prefix, Message) do { if constexpr ((Level) >= LOG_MINLEVEL) {         \
+    if ((Level) >= ::Internal::Runtimelevel.load(std::memory_order_relaxed)) {                    \
+        static ::Internal::Ratelimiter_t Ratelimiter{ Prefix, __FILE__, __LINE__ };               \
+        uint32_t Suppressed = 0; ::Internal::Flushsuppressed();                                   \
+        if (Ratelimiter.Allow(Suppressed)) ::Logratelimited(Message, Prefix, Suppressed); } } } while (false)
+
 // Debug information logging.
-#if defined(NDEBUG)
-    #define Printfunction()
-    #define Debugprint(string)
-#else
-    #define Printfunction() Logformatted(__FUNCTION__, 'T')
-    #define Debugprint(string) Logformatted(string, 'D')
-#endif
+#define Printfunction() Logleveled(LOG_TRACE, 'T', __FUNCTION__)
+#define Debugprint(string) Logleveled(LOG_DEBUG, 'D', string)
 
 // General information.
-#define Infoprint(string) Logformatted(string, 'I')
+#define Infoprint(string) Logleveled(LOG_INFO, 'I', string)
+#define Warningprint(string) Logleveled(LOG_WARNING, 'W', string)
+#define Errorprint(string) Logleveled(LOG_ERROR, 'E', string)
 #define vaprint(format, ...) Logprint(va(format, __VA_ARGS__))
 
+// Binary logging, formatting is deferred to Tools/Logdecoder.
+#define Binaryprint(Level, ...) do {                                                                           \
+    static const uint32_t Formatid = Binarylog::Registerformat(Binarylog::Internal::Firstargument(__VA_ARGS__)); \
+    Binarylog::Record(Formatid, Level, __VA_ARGS__); } while (false)
+
 // Some performance tweaking.
 #if defined(_WIN32)
     #define likely(x)       x
@@ -30,5 +39,22 @@
     #define unlikely(x)     __builtin_expect(!!(x), 0)
 #endif
 
-// Patternscanning.
-#define Findpattern(Segment, String) Pattern::_Findpattern(Segment, Pattern::Stringtopattern(String), Pattern::Stringtomask(String))
+// Patternscanning, string literals are parsed at compile-time and other strings at runtime.
+#define Findpattern(Segment, String) [&](auto Quoted) -> size_t { if constexpr (decltype(Quoted)::value) {          \
+    static constexpr auto Literal = Pattern::Makeliteral(Pattern::Internal::Literalarray<decltype(Quoted)>(String));   \
+    return Pattern::_Findpattern(Segment, Literal.View()); }                                                        \
+    else return Pattern::_Findpattern(Segment, Pattern::Stringtopattern(String), Pattern::Stringtomask(String)); }   \
+    (std::bool_constant<Pattern::Internal::Isquoted(#String)>{})
+
+// Hook profiling, times the rest of the scope. Nothing is emitted unless HOOKING_PROFILE is set.
+#if HOOKING_PROFILE
+    #define Profilehook(Name) static const uint32_t Profilesite_ = Hooking::Profiler::Registersite(Name);  \
+        Hooking::Profiler::Scope_t Profilescope_(Profilesite_)
+#else
+    #define Profilehook(Name) ((void)0)
+#endif
+
+// Bytebuffer schemas, lists the fields to serialize in order.
+#define BYTEBUFFER_SCHEMA(...)                                          \
+    auto Schemafields() { return std::tie(__VA_ARGS__); }               \
+    auto Schemafields() const { return std::tie(__VA_ARGS__); }
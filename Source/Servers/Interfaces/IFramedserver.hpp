@@ -0,0 +1,142 @@
+/*
+    Initial author: Convery (tcn@hedgehogscience.com)
+    Started: 19-10-2026
+    License: MIT
+    Notes:
+        Provides length-prefixed Bytebuffer messages over a stream.
+        Frames are a uint32_t length followed by the message data.
+*/
+
+#pragma once
+#include "../../Stdinclude.hpp"
+
+struct IFramedserver : IStreamserver
+{
+    // Larger frames are treated as a corrupt stream.
+    uint32_t Maxframesize = 16 * 1024 * 1024;
+
+    // Callback on complete frames, called without Threadguard held. Frames from one socket are
+    // dispatched in order by a single thread, the view is only valid during the call.
+    virtual void onMessage(const size_t Socket, Bytebufferview &Message) = 0;
+
+    // Replies sent to the current socket from onMessage are appended to the stream once all frames are handled.
+    virtual void Sendmessage(const size_t Socket, const void *Databuffer, const uint32_t Datasize)
+    {
+        auto &Pending = Pendingframes();
+        if (Pending.Owner == this && Pending.Socket == Socket)
+        {
+            Appendframe(Pending.Frames, Databuffer, Datasize);
+            return;
+        }
+
+        // Header and data are enqueued as a single append.
+        std::vector<uint8_t> Frame;
+        Appendframe(Frame, Databuffer, Datasize);
+        IStreamserver::Send(Socket, Frame.data(), uint32_t(Frame.size()));
+    }
+    virtual void Sendmessage(const size_t Socket, Bytebuffer &Message)
+    {
+        return Sendmessage(Socket, Message.Data(), uint32_t(Message.Size()));
+    }
+
+    // Callback on incoming data, Threadguard is held.
+    virtual void onData(const size_t Socket, std::vector<uint8_t> &Stream)
+    {
+        // The thread already dispatching this socket picks up the new frames.
+        if (!Dispatching.insert(Socket).second) return;
+
+        auto &Pending = Pendingframes();
+        std::vector<uint8_t> Frames;
+
+        while (true)
+        {
+            // The stream is taken whole so data arriving while unlocked can not move the frames.
+            const size_t Framebytes = Completeframes(Socket, Stream);
+            if (0 == Framebytes) break;
+            Frames.swap(Stream);
+
+            Pending.Owner = this;
+            Pending.Socket = Socket;
+            Threadguard.unlock();
+            {
+                for (size_t Offset = 0; Offset < Framebytes;)
+                {
+                    uint32_t Framesize;
+                    std::memcpy(&Framesize, Frames.data() + Offset, sizeof(uint32_t));
+
+                    Bytebufferview Message(Framesize, Frames.data() + Offset + sizeof(uint32_t));
+                    Offset += sizeof(uint32_t) + Framesize;
+                    onMessage(Socket, Message);
+                }
+            }
+            Threadguard.lock();
+            Pending.Owner = nullptr;
+
+            // Compact once, the partial frame goes in front of whatever arrived meanwhile.
+            if (Frames.size() > Framebytes && Validconnection[Socket])
+                Stream.insert(Stream.begin(), Frames.begin() + Framebytes, Frames.end());
+            Frames.clear();
+
+            // Replies go out as one append.
+            if (!Pending.Frames.empty())
+            {
+                auto &Outgoing = Outgoingstream[Socket];
+                Outgoing.insert(Outgoing.end(), Pending.Frames.begin(), Pending.Frames.end());
+                Pending.Frames.clear();
+            }
+        }
+
+        Dispatching.erase(Socket);
+    }
+
+private:
+    // Sockets with a thread in onMessage, guarded by Threadguard.
+    std::unordered_set<size_t> Dispatching;
+
+    // Returns the size of the complete frames at the start of the stream.
+    size_t Completeframes(const size_t Socket, std::vector<uint8_t> &Stream)
+    {
+        size_t Offset = 0;
+        while (Stream.size() - Offset >= sizeof(uint32_t))
+        {
+            uint32_t Framesize;
+            std::memcpy(&Framesize, Stream.data() + Offset, sizeof(uint32_t));
+
+            // The framing is lost, so the connection is too.
+            if (Framesize > Maxframesize)
+            {
+                Errorprint(va("Dropping the stream for socket %zu, frame of %u bytes.", Socket, Framesize));
+                Validconnection[Socket] = false;
+                Stream.resize(Offset);
+                break;
+            }
+            if (Stream.size() - Offset - sizeof(uint32_t) < Framesize) break;
+
+            Offset += sizeof(uint32_t) + Framesize;
+        }
+
+        return Offset;
+    }
+
+    // Per thread queue of replies during dispatch.
+    struct Pendingframes_t
+    {
+        IFramedserver *Owner{};
+        size_t Socket{};
+        std::vector<uint8_t> Frames;
+    };
+    static Pendingframes_t &Pendingframes()
+    {
+        static thread_local Pendingframes_t Pending;
+        return Pending;
+    }
+    static void Appendframe(std::vector<uint8_t> &Output, const void *Databuffer, const uint32_t Datasize)
+    {
+        auto Pointer = reinterpret_cast<const uint8_t *>(Databuffer);
+        size_t Offset = Output.size();
+
+        Output.resize(Offset + sizeof(uint32_t) + Datasize);
+        std::memcpy(Output.data() + Offset, &Datasize, sizeof(uint32_t));
+        if (Datasize) std::memcpy(Output.data() + Offset + sizeof(uint32_t), Pointer, Datasize);
+    }
+};
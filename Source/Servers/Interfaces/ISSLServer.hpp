@@ -82,7 +82,7 @@ struct ISSLServer : IStreamserver
             return true;
         } while (false);
 
-        Infoprint(va("Failed to create a SSL certificate for \"%*s\"", Hostname.size(), Hostname.data()));
+        Errorprint(va("Failed to create a SSL certificate for \"%*s\"", Hostname.size(), Hostname.data()));
         SSLCertificate = nullptr;
         SSLKey = nullptr;
         return false;
@@ -142,7 +142,7 @@ struct ISSLServer : IStreamserver
                         BIO_set_nbio(Read_BIO[Socket], 1);
 
                         State[Socket] = SSL_new(Context[Socket]);
-                        if(!State[Socket]) Infoprint("OpenSSL error: Failed to create the SSL state.");
+                        if(!State[Socket]) Errorprint("OpenSSL error: Failed to create the SSL state.");
 
                         SSL_set_bio(State[Socket], Read_BIO[Socket], Write_BIO[Socket]);
                         SSL_set_verify(State[Socket], SSL_VERIFY_NONE, NULL);
@@ -195,13 +195,13 @@ struct ISSLServer : IStreamserver
         // Load the certificate and key for this server.
         {
             Resultcode = SSL_CTX_use_certificate(Context[Socket], SSLCertificate);
-            if (Resultcode != 1) Infoprint(va("OpenSSL error: %s", ERR_error_string(Resultcode, NULL)).c_str());
+            if (Resultcode != 1) Errorprint(va("OpenSSL error: %s", ERR_error_string(Resultcode, NULL)).c_str());
 
             Resultcode = SSL_CTX_use_PrivateKey(Context[Socket], SSLKey);
-            if (Resultcode != 1) Infoprint(va("OpenSSL error: %s", ERR_error_string(Resultcode, NULL)).c_str());
+            if (Resultcode != 1) Errorprint(va("OpenSSL error: %s", ERR_error_string(Resultcode, NULL)).c_str());
 
             Resultcode = SSL_CTX_check_private_key(Context[Socket]);
-            if (Resultcode != 1) Infoprint(va("OpenSSL error: %s", ERR_error_string(Resultcode, NULL)).c_str());
+            if (Resultcode != 1) Errorprint(va("OpenSSL error: %s", ERR_error_string(Resultcode, NULL)).c_str());
         }
 
         // Create the BIO buffers.
@@ -215,7 +215,7 @@ struct ISSLServer : IStreamserver
         // Initialize the SSL state.
         {
             State[Socket] = SSL_new(Context[Socket]);
-            if (!State[Socket]) Infoprint("OpenSSL error: Failed to create the SSL state.");
+            if (!State[Socket]) Errorprint("OpenSSL error: Failed to create the SSL state.");
 
             SSL_set_bio(State[Socket], Read_BIO[Socket], Write_BIO[Socket]);
             SSL_set_verify(State[Socket], SSL_VERIFY_NONE, NULL);
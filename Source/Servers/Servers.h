@@ -10,6 +10,7 @@
 #include "../Stdinclude.hpp"
 #include "Interfaces/IServer.hpp"
 #include "Interfaces/IStreamserver.hpp"
+#include "Interfaces/IFramedserver.hpp"
 #include "Interfaces/IDatagramserver.hpp"
 
 #include "Interfaces/ISSLServer.hpp"
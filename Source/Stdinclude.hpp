@@ -14,13 +14,21 @@
 
 // Standard libraries.
 #include <unordered_map>
+#include <unordered_set>
+#include <algorithm>
+#include <charconv>
 #include <string_view>
+#include <type_traits>
+#include <atomic>
+#include <utility>
 #include <assert.h>
+#include <cstddef>
 #include <cstdint>
 #include <cstdarg>
 #include <cstring>
 #include <cstdio>
 #include <vector>
+#include <tuple>
 #include <memory>
 #include <chrono>
 #include <thread>
@@ -50,10 +58,14 @@
 #include "Utility/Filesystem.hpp"
 #include "Utility/Memprotect.hpp"
 #include "Utility/Bytebuffer.hpp"
+#include "Utility/Bytebufferschema.hpp"
 #include "Utility/PackageFS.hpp"
 #include "Utility/FNV1Hash.hpp"
+#include "Utility/Disassembler.hpp"
 #include "Utility/Hooking.hpp"
+#include "Utility/Hookprofiler.hpp"
 #include "Utility/Logfile.hpp"
+#include "Utility/Binarylog.hpp"
 #include "Utility/Base64.hpp"
 
 // Includes for our components.
@@ -0,0 +1,351 @@
+/*
+    Initial author: Convery (tcn@hedgehogscience.com)
+    Started: 19-10-2026
+    License: MIT
+    Notes:
+        Base64 encoding and decoding of strings.
+        Blocks are processed with SSSE3 or AVX2 when
+        available, selected at runtime.
+*/
+
+#include "../Stdinclude.hpp"
+
+// Neither extension is part of the x64 baseline, both are selected at runtime.
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+    #include <immintrin.h>
+    #define BASE64_SIMD
+    #if defined(_WIN32)
+        #define BASE64_TARGET_SSSE3
+        #define BASE64_TARGET_AVX2
+    #else
+        #define BASE64_TARGET_SSSE3 __attribute__((target("ssse3")))
+        #define BASE64_TARGET_AVX2 __attribute__((target("avx2")))
+    #endif
+#endif
+
+namespace Base64
+{
+    namespace Internal
+    {
+        // Tables for the vector kernels, see the notes by the kernels.
+        struct Lookups_t
+        {
+            int8_t Shift[16];
+            int8_t Lowmask[16];
+            int8_t Highmask[16];
+            int8_t Roll[16];
+            char Special;
+        };
+        struct Alphabet_t
+        {
+            const char *Table;
+            bool Pad;
+            Lookups_t Lookups;
+            uint8_t Reverse[256]{};
+
+            // Invalid characters map to 0xFF.
+            constexpr Alphabet_t(const char *Characters, bool Padding, const Lookups_t &Vector) : Table(Characters), Pad(Padding), Lookups(Vector)
+            {
+                for (auto &Item : Reverse) Item = 0xFF;
+                for (uint8_t i = 0; i < 64; ++i) Reverse[uint8_t(Characters[i])] = i;
+            }
+        };
+
+        static constexpr Alphabet_t Standard("ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/", true,
+        {
+            { 'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0 },
+            { 0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A },
+            { 0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10 },
+            { 0, 0, 19, 4, -65, -65, -71, -71, 0, 0, 16, 0, 0, 0, 0, 0 },
+            '/'
+        });
+        static constexpr Alphabet_t Urlsafe("ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_", false,
+        {
+            { 'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '-' - 62, '_' - 63, 'A', 0, 0 },
+            { 0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x3B, 0x3B, 0x3A, 0x3B, 0x33 },
+            { 0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x20, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10 },
+            { 0, 0, 17, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, -32, 0, 0 },
+            '_'
+        });
+
+        // Handles the tails and CPUs without the extensions, returns the characters written.
+        size_t Encodescalar(const uint8_t *Input, size_t Length, char *Output, const Alphabet_t &Alphabet)
+        {
+            const char *Table = Alphabet.Table;
+            const char *Start = Output;
+
+            for (; Length >= 3; Length -= 3, Input += 3)
+            {
+                const uint32_t Triplet = (uint32_t(Input[0]) << 16) | (uint32_t(Input[1]) << 8) | Input[2];
+                Output[0] = Table[(Triplet >> 18) & 0x3F];
+                Output[1] = Table[(Triplet >> 12) & 0x3F];
+                Output[2] = Table[(Triplet >> 6) & 0x3F];
+                Output[3] = Table[Triplet & 0x3F];
+                Output += 4;
+            }
+
+            if (Length)
+            {
+                const uint32_t Triplet = (uint32_t(Input[0]) << 16) | (Length == 2 ? uint32_t(Input[1]) << 8 : 0);
+                *Output++ = Table[(Triplet >> 18) & 0x3F];
+                *Output++ = Table[(Triplet >> 12) & 0x3F];
+
+                if (Length == 2) *Output++ = Table[(Triplet >> 6) & 0x3F];
+                else if (Alphabet.Pad) *Output++ = '=';
+                if (Alphabet.Pad) *Output++ = '=';
+            }
+
+            return size_t(Output - Start);
+        }
+
+        // The caller strips the padding and rejects lengths of 4n + 1.
+        bool Decodescalar(const char *Input, size_t Length, uint8_t *Output, const Alphabet_t &Alphabet)
+        {
+            const uint8_t *Reverse = Alphabet.Reverse;
+
+            for (; Length >= 4; Length -= 4, Input += 4)
+            {
+                const uint8_t A = Reverse[uint8_t(Input[0])], B = Reverse[uint8_t(Input[1])];
+                const uint8_t C = Reverse[uint8_t(Input[2])], D = Reverse[uint8_t(Input[3])];
+                if ((A | B | C | D) & 0x80) return false;
+
+                const uint32_t Triplet = (uint32_t(A) << 18) | (uint32_t(B) << 12) | (uint32_t(C) << 6) | D;
+                Output[0] = uint8_t(Triplet >> 16);
+                Output[1] = uint8_t(Triplet >> 8);
+                Output[2] = uint8_t(Triplet);
+                Output += 3;
+            }
+
+            if (Length)
+            {
+                const uint8_t A = Reverse[uint8_t(Input[0])], B = Reverse[uint8_t(Input[1])];
+                const uint8_t C = Length == 3 ? Reverse[uint8_t(Input[2])] : 0;
+                if ((A | B | C) & 0x80) return false;
+
+                const uint32_t Triplet = (uint32_t(A) << 18) | (uint32_t(B) << 12) | (uint32_t(C) << 6);
+                Output[0] = uint8_t(Triplet >> 16);
+                if (Length == 3) Output[1] = uint8_t(Triplet >> 8);
+            }
+
+            return true;
+        }
+
+        #if defined(BASE64_SIMD)
+        /*
+            Encoding spreads 12 bytes over 16 lanes, the multiplies shift each
+            sextet into its own byte. The alphabet is contiguous in five ranges
+            so a saturated subtract and compare give a range index, which picks
+            the offset to add through a shuffle.
+
+            Decoding splits every character into nibbles, the low nibble selects
+            the high nibbles it is invalid for as a bitmask. The high nibble and
+            the one special character pick the offset back to the sextet, which
+            the multiply-adds pack into 12 bytes.
+        */
+        BASE64_TARGET_SSSE3 inline __m128i Splitsextets(__m128i Input)
+        {
+            Input = _mm_shuffle_epi8(Input, _mm_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10));
+            const auto High = _mm_mulhi_epu16(_mm_and_si128(Input, _mm_set1_epi32(0x0FC0FC00)), _mm_set1_epi32(0x04000040));
+            const auto Low = _mm_mullo_epi16(_mm_and_si128(Input, _mm_set1_epi32(0x003F03F0)), _mm_set1_epi32(0x01000010));
+            return _mm_or_si128(High, Low);
+        }
+        BASE64_TARGET_SSSE3 inline __m128i Translate(__m128i Sextets, __m128i Shift)
+        {
+            auto Range = _mm_subs_epu8(Sextets, _mm_set1_epi8(51));
+            const auto Upper = _mm_cmpgt_epi8(_mm_set1_epi8(26), Sextets);
+            Range = _mm_or_si128(Range, _mm_and_si128(Upper, _mm_set1_epi8(13)));
+            return _mm_add_epi8(Sextets, _mm_shuffle_epi8(Shift, Range));
+        }
+        BASE64_TARGET_SSSE3 size_t EncodeSSSE3(const uint8_t *Input, size_t Length, char *Output, const Alphabet_t &Alphabet)
+        {
+            const auto Shift = _mm_loadu_si128((const __m128i *)Alphabet.Lookups.Shift);
+            size_t Written = 0;
+
+            // Reads 16 bytes to consume 12.
+            for (; Length >= 16; Length -= 12, Input += 12, Written += 16)
+            {
+                const auto Sextets = Splitsextets(_mm_loadu_si128((const __m128i *)Input));
+                _mm_storeu_si128((__m128i *)(Output + Written), Translate(Sextets, Shift));
+            }
+
+            return Written + Encodescalar(Input, Length, Output + Written, Alphabet);
+        }
+
+        BASE64_TARGET_SSSE3 inline bool Packsextets(__m128i Input, const Lookups_t &Lookups, __m128i &Output)
+        {
+            const auto Nibblemask = _mm_set1_epi8(0x0F);
+            const auto High = _mm_and_si128(_mm_srli_epi32(Input, 4), Nibblemask);
+            const auto Low = _mm_and_si128(Input, Nibblemask);
+
+            const auto Lowmask = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)Lookups.Lowmask), Low);
+            const auto Highmask = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)Lookups.Highmask), High);
+            const auto Valid = _mm_cmpeq_epi8(_mm_and_si128(Lowmask, Highmask), _mm_setzero_si128());
+            if (_mm_movemask_epi8(Valid) != 0xFFFF) return false;
+
+            const auto Special = _mm_and_si128(_mm_cmpeq_epi8(Input, _mm_set1_epi8(Lookups.Special)), _mm_set1_epi8(8));
+            const auto Roll = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)Lookups.Roll), _mm_or_si128(High, Special));
+            const auto Sextets = _mm_add_epi8(Input, Roll);
+
+            const auto Pairs = _mm_maddubs_epi16(Sextets, _mm_set1_epi32(0x01400140));
+            const auto Triplets = _mm_madd_epi16(Pairs, _mm_set1_epi32(0x00011000));
+            Output = _mm_shuffle_epi8(Triplets, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+            return true;
+        }
+        BASE64_TARGET_SSSE3 bool DecodeSSSE3(const char *Input, size_t Length, uint8_t *Output, const Alphabet_t &Alphabet)
+        {
+            // Invalid blocks are left for the scalar path to reject.
+            for (; Length >= 16; Length -= 16, Input += 16, Output += 12)
+            {
+                __m128i Bytes;
+                if (!Packsextets(_mm_loadu_si128((const __m128i *)Input), Alphabet.Lookups, Bytes)) break;
+
+                const uint32_t Last = uint32_t(_mm_cvtsi128_si32(_mm_srli_si128(Bytes, 8)));
+                _mm_storel_epi64((__m128i *)Output, Bytes);
+                std::memcpy(Output + 8, &Last, sizeof(Last));
+            }
+
+            return Decodescalar(Input, Length, Output, Alphabet);
+        }
+
+        // The same steps on two lanes of 12 bytes.
+        BASE64_TARGET_AVX2 size_t EncodeAVX2(const uint8_t *Input, size_t Length, char *Output, const Alphabet_t &Alphabet)
+        {
+            const auto Shift = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)Alphabet.Lookups.Shift));
+            const auto Order = _mm256_broadcastsi128_si256(_mm_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10));
+            size_t Written = 0;
+
+            // Reads 28 bytes to consume 24.
+            for (; Length >= 28; Length -= 24, Input += 24, Written += 32)
+            {
+                const auto Low = _mm_loadu_si128((const __m128i *)Input);
+                const auto High = _mm_loadu_si128((const __m128i *)(Input + 12));
+                const auto Bytes = _mm256_shuffle_epi8(_mm256_inserti128_si256(_mm256_castsi128_si256(Low), High, 1), Order);
+
+                const auto Upperbits = _mm256_mulhi_epu16(_mm256_and_si256(Bytes, _mm256_set1_epi32(0x0FC0FC00)), _mm256_set1_epi32(0x04000040));
+                const auto Lowerbits = _mm256_mullo_epi16(_mm256_and_si256(Bytes, _mm256_set1_epi32(0x003F03F0)), _mm256_set1_epi32(0x01000010));
+                const auto Sextets = _mm256_or_si256(Upperbits, Lowerbits);
+
+                auto Range = _mm256_subs_epu8(Sextets, _mm256_set1_epi8(51));
+                const auto Upper = _mm256_cmpgt_epi8(_mm256_set1_epi8(26), Sextets);
+                Range = _mm256_or_si256(Range, _mm256_and_si256(Upper, _mm256_set1_epi8(13)));
+                _mm256_storeu_si256((__m256i *)(Output + Written), _mm256_add_epi8(Sextets, _mm256_shuffle_epi8(Shift, Range)));
+            }
+
+            // The tail runs legacy SSE, which stalls on dirty upper halves.
+            _mm256_zeroupper();
+            return Written + EncodeSSSE3(Input, Length, Output + Written, Alphabet);
+        }
+        BASE64_TARGET_AVX2 bool DecodeAVX2(const char *Input, size_t Length, uint8_t *Output, const Alphabet_t &Alphabet)
+        {
+            const auto &Lookups = Alphabet.Lookups;
+            const auto Lowtable = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)Lookups.Lowmask));
+            const auto Hightable = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)Lookups.Highmask));
+            const auto Rolltable = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)Lookups.Roll));
+            const auto Order = _mm256_broadcastsi128_si256(_mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+            const auto Nibblemask = _mm256_set1_epi8(0x0F);
+
+            for (; Length >= 32; Length -= 32, Input += 32, Output += 24)
+            {
+                const auto Characters = _mm256_loadu_si256((const __m256i *)Input);
+                const auto High = _mm256_and_si256(_mm256_srli_epi32(Characters, 4), Nibblemask);
+                const auto Low = _mm256_and_si256(Characters, Nibblemask);
+
+                const auto Invalid = _mm256_and_si256(_mm256_shuffle_epi8(Lowtable, Low), _mm256_shuffle_epi8(Hightable, High));
+                if (_mm256_movemask_epi8(_mm256_cmpeq_epi8(Invalid, _mm256_setzero_si256())) != -1) break;
+
+                const auto Special = _mm256_and_si256(_mm256_cmpeq_epi8(Characters, _mm256_set1_epi8(Lookups.Special)), _mm256_set1_epi8(8));
+                const auto Sextets = _mm256_add_epi8(Characters, _mm256_shuffle_epi8(Rolltable, _mm256_or_si256(High, Special)));
+
+                const auto Pairs = _mm256_maddubs_epi16(Sextets, _mm256_set1_epi32(0x01400140));
+                const auto Triplets = _mm256_shuffle_epi8(_mm256_madd_epi16(Pairs, _mm256_set1_epi32(0x00011000)), Order);
+                const auto Bytes = _mm256_permutevar8x32_epi32(Triplets, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7));
+
+                _mm_storeu_si128((__m128i *)Output, _mm256_castsi256_si128(Bytes));
+                _mm_storel_epi64((__m128i *)(Output + 16), _mm256_extracti128_si256(Bytes, 1));
+            }
+
+            _mm256_zeroupper();
+            return DecodeSSSE3(Input, Length, Output, Alphabet);
+        }
+        #endif
+
+        // Select the widest kernels the CPU supports.
+        struct Kernels_t
+        {
+            size_t (*Encode)(const uint8_t *Input, size_t Length, char *Output, const Alphabet_t &Alphabet);
+            bool (*Decode)(const char *Input, size_t Length, uint8_t *Output, const Alphabet_t &Alphabet);
+        };
+        Kernels_t Selectkernels()
+        {
+            #if defined(BASE64_SIMD)
+                #if defined(_WIN32)
+                    int Registers[4];
+                    __cpuid(Registers, 0);
+                    const int Highest = Registers[0];
+                    __cpuid(Registers, 1);
+                    const bool SSSE3 = Registers[2] & (1 << 9);
+                    const bool OSXSAVE = Registers[2] & (1 << 27);
+                    if (Highest >= 7)
+                    {
+                        __cpuidex(Registers, 7, 0);
+                        bool AVX2 = Registers[1] & (1 << 5);
+                        if (AVX2 && OSXSAVE && (_xgetbv(0) & 6) == 6) return { EncodeAVX2, DecodeAVX2 };
+                    }
+                    if (SSSE3) return { EncodeSSSE3, DecodeSSSE3 };
+                #else
+                    if (__builtin_cpu_supports("avx2")) return { EncodeAVX2, DecodeAVX2 };
+                    if (__builtin_cpu_supports("ssse3")) return { EncodeSSSE3, DecodeSSSE3 };
+                #endif
+            #endif
+            return { Encodescalar, Decodescalar };
+        }
+        const Kernels_t &Kernels()
+        {
+            // Selected on first use, static initializers may already encode.
+            static const Kernels_t Selected = Selectkernels();
+            return Selected;
+        }
+    }
+
+    // Output needs Encodedsize() characters, returns the number written.
+    size_t Encode(const void *Input, size_t Length, char *Output, bool Urlsafe)
+    {
+        return Internal::Kernels().Encode((const uint8_t *)Input, Length, Output, Urlsafe ? Internal::Urlsafe : Internal::Standard);
+    }
+
+    // Outputsize is the capacity on input and the decoded length on return, padding is optional.
+    bool Decode(std::string_view Input, void *Output, size_t &Outputsize, bool Urlsafe)
+    {
+        size_t Length = Input.size();
+        if (Length && Length % 4 == 0 && Input[Length - 1] == '=')
+        {
+            --Length;
+            if (Input[Length - 1] == '=') --Length;
+        }
+        if (Length % 4 == 1) return false;
+
+        const size_t Decoded = (Length / 4) * 3 + (Length % 4 ? Length % 4 - 1 : 0);
+        if (Decoded > Outputsize) return false;
+
+        if (!Internal::Kernels().Decode(Input.data(), Length, (uint8_t *)Output, Urlsafe ? Internal::Urlsafe : Internal::Standard)) return false;
+        Outputsize = Decoded;
+        return true;
+    }
+
+    // Invalid input decodes to an empty string.
+    std::string Encode(std::string_view Input, bool Urlsafe)
+    {
+        std::string Result(Encodedsize(Input.size(), Urlsafe), '\0');
+        Result.resize(Encode(Input.data(), Input.size(), Result.data(), Urlsafe));
+        return Result;
+    }
+    std::string Decode(std::string_view Input, bool Urlsafe)
+    {
+        std::string Result(Decodedsize(Input.size()), '\0');
+        size_t Outputsize = Result.size();
+
+        if (!Decode(Input, Result.data(), Outputsize, Urlsafe)) return {};
+        Result.resize(Outputsize);
+        return Result;
+    }
+}
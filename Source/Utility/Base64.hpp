@@ -4,6 +4,8 @@
     License: MIT
     Notes:
         Base64 encoding and decoding of strings.
+        Blocks are processed with SSSE3 or AVX2 when
+        available, selected at runtime.
 */
 
 #pragma once
@@ -11,67 +13,23 @@
 
 namespace Base64
 {
-    namespace Internal
+    // URL-safe output uses '-' and '_' and is not padded.
+    constexpr size_t Encodedsize(size_t Length, bool Urlsafe = false)
     {
-        static constexpr char Table[65] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
-        static constexpr char Reversetable[128] = {
-        64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64,
-        64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64,
-        64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 62, 64, 64, 64, 63,
-        52, 53, 54, 55, 56, 57, 58, 59, 60, 61, 64, 64, 64, 64, 64, 64,
-        64,  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14,
-        15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 64, 64, 64, 64, 64,
-        64, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40,
-        41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, 64, 64, 64, 64, 64
-        };
+        return Urlsafe ? (Length * 4 + 2) / 3 : ((Length + 2) / 3) * 4;
     }
-
-    inline std::string Encode(std::string_view Input)
+    constexpr size_t Decodedsize(size_t Length)
     {
-        std::string Result((((Input.size() + 2) / 3) * 4), '=');
-        size_t Outputposition = 0;
-        uint32_t Accumulator = 0;
-        int32_t Bits = 0;
-
-        for (auto &Item : Input)
-        {
-            Accumulator = (Accumulator << 8) | (Item & 0xFF);
-            Bits += 8;
-            while (Bits >= 6)
-            {
-                Bits -= 6;
-                Result[Outputposition++] = Internal::Table[(Accumulator >> Bits) & 0x3F];
-            }
-        }
-
-        if (Bits)
-        {
-            Accumulator <<= 6 - Bits;
-            Result[Outputposition++] = Internal::Table[Accumulator & 0x3F];
-        }
-
-        return Result;
+        return ((Length + 3) / 4) * 3;
     }
-    inline std::string Decode(std::string_view Input)
-    {
-        std::string Result;
-        uint32_t Accumulator = 0;
-        int32_t Bits = 0;
-
-        for (auto &Item : Input)
-        {
-            if (Item == '=') continue;
 
-            Accumulator = (Accumulator << 6) | Internal::Reversetable[uint8_t(Item)];
-            Bits += 6;
+    // Output needs Encodedsize() characters, returns the number written.
+    size_t Encode(const void *Input, size_t Length, char *Output, bool Urlsafe = false);
 
-            if (Bits >= 8)
-            {
-                Bits -= 8;
-                Result += char((Accumulator >> Bits) & 0xFF);
-            }
-        }
+    // Outputsize is the capacity on input and the decoded length on return, padding is optional.
+    bool Decode(std::string_view Input, void *Output, size_t &Outputsize, bool Urlsafe = false);
 
-        return Result;
-    }
+    // Invalid input decodes to an empty string.
+    std::string Encode(std::string_view Input, bool Urlsafe = false);
+    std::string Decode(std::string_view Input, bool Urlsafe = false);
 }
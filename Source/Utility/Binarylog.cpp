@@ -0,0 +1,131 @@
+/*
+    Initial author: Convery (tcn@hedgehogscience.com)
+    Started: 19-10-2026
+    License: MIT
+    Notes:
+        Binary logging where the callsite only records the
+        format-ID and raw arguments, Tools/Logdecoder.cpp
+        does the formatting offline.
+*/
+
+#include "../Stdinclude.hpp"
+
+#if defined(__linux__)
+#include <sys/syscall.h>
+#endif
+
+namespace Binarylog
+{
+    // Internal state.
+    namespace Internal
+    {
+        #if !defined(MODULENAME)
+            #define MODULENAME "Invalid"
+        #endif
+
+        constexpr const char *Filepath = "./Plugins/Logs/" MODULENAME ".blog";
+        constexpr size_t Buffersize = 64 * 1024;
+        static std::mutex Threadguard;
+        static uint32_t Formatcount = 0;
+        static bool Truncated = false;
+
+        // Append to the logfile, the first write this session truncates it.
+        void Writefile(const void *Buffer, size_t Length)
+        {
+            Threadguard.lock();
+            {
+                auto Filehandle = std::fopen(Filepath, Truncated ? "ab" : "wb");
+                if (Filehandle)
+                {
+                    std::fwrite(Buffer, Length, 1, Filehandle);
+                    std::fclose(Filehandle);
+                    Truncated = true;
+                }
+            }
+            Threadguard.unlock();
+        }
+
+        // Per thread storage that is drained when full or on thread-exit.
+        struct Threadbuffer
+        {
+            std::vector<uint8_t> Storage;
+            size_t Size{};
+
+            void Drain()
+            {
+                if (Size) Writefile(Storage.data(), Size);
+                Size = 0;
+            }
+
+            Threadbuffer() : Storage(Buffersize) {}
+            ~Threadbuffer() { Drain(); }
+        };
+        static thread_local Threadbuffer Localbuffer;
+
+        uint8_t *Reserve(size_t Length)
+        {
+            if (unlikely(Localbuffer.Size + Length > Localbuffer.Storage.size()))
+            {
+                Localbuffer.Drain();
+
+                // Oversized records get a temporary buffer.
+                if (Length > Buffersize) Localbuffer.Storage.resize(Length);
+                else if (Localbuffer.Storage.size() > Buffersize)
+                {
+                    Localbuffer.Storage.resize(Buffersize);
+                    Localbuffer.Storage.shrink_to_fit();
+                }
+            }
+
+            return Localbuffer.Storage.data() + Localbuffer.Size;
+        }
+        void Commit(size_t Length)
+        {
+            Localbuffer.Size += Length;
+        }
+        uint32_t Threadid()
+        {
+            #if defined(_WIN32)
+                static thread_local uint32_t Cachedid = uint32_t(GetCurrentThreadId());
+            #elif defined(__linux__)
+                static thread_local uint32_t Cachedid = uint32_t(syscall(SYS_gettid));
+            #else
+                static std::atomic<uint32_t> Threadcount{};
+                static thread_local uint32_t Cachedid = ++Threadcount;
+            #endif
+
+            return Cachedid;
+        }
+    }
+
+    // Register a format-string once per callsite, writes the definition to disk.
+    uint32_t Registerformat(const char *Format)
+    {
+        uint32_t Formatid;
+        Internal::Threadguard.lock();
+        {
+            Formatid = Internal::Formatcount++;
+        }
+        Internal::Threadguard.unlock();
+
+        // Definitions go straight to disk so they always precede their messages.
+        Recordheader Header{};
+        Header.Kind = BL_FORMAT;
+        Header.Formatid = Formatid;
+        Header.Threadid = Internal::Threadid();
+        Header.Payloadsize = uint32_t(std::strlen(Format));
+
+        std::vector<uint8_t> Buffer(sizeof(Recordheader) + Header.Payloadsize);
+        std::memcpy(Buffer.data(), &Header, sizeof(Recordheader));
+        std::memcpy(Buffer.data() + sizeof(Recordheader), Format, Header.Payloadsize);
+        Internal::Writefile(Buffer.data(), Buffer.size());
+
+        return Formatid;
+    }
+
+    // Write the current threads buffered records to disk.
+    void Flush()
+    {
+        Internal::Localbuffer.Drain();
+    }
+}
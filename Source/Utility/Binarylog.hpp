@@ -0,0 +1,130 @@
+/*
+    Initial author: Convery (tcn@hedgehogscience.com)
+    Started: 19-10-2026
+    License: MIT
+    Notes:
+        Binary logging where the callsite only records the
+        format-ID and raw arguments, Tools/Logdecoder.cpp
+        does the formatting offline.
+*/
+
+#pragma once
+#include "../Stdinclude.hpp"
+
+namespace Binarylog
+{
+    // On-disk layout, keep in sync with Tools/Logdecoder.cpp.
+    enum Recordkind : uint8_t
+    {
+        BL_FORMAT = 0,
+        BL_MESSAGE = 1,
+    };
+    enum Argumentkind : uint8_t
+    {
+        BL_SINT = 'i',
+        BL_UINT = 'u',
+        BL_FLOAT = 'f',
+        BL_STRING = 's',
+        BL_POINTER = 'p',
+    };
+    struct Recordheader
+    {
+        uint8_t Kind;
+        uint8_t Level;
+        uint16_t Argumentcount;
+        uint32_t Formatid;
+        uint32_t Threadid;
+        uint32_t Payloadsize;
+        uint64_t Timestamp;
+    };
+    static_assert(sizeof(Recordheader) == 24, "The decoder expects a packed 24 byte header.");
+
+    // Register a format-string once per callsite, writes the definition to disk.
+    uint32_t Registerformat(const char *Format);
+
+    // Write the current threads buffered records to disk.
+    void Flush();
+
+    // Internal state.
+    namespace Internal
+    {
+        // Reserve space in the current threads buffer, draining it to disk as needed.
+        uint8_t *Reserve(size_t Length);
+        void Commit(size_t Length);
+        uint32_t Threadid();
+
+        // Helper for the macro to extract the format.
+        template <typename ... Args>
+        constexpr const char *Firstargument(const char *Format, Args && ...) { return Format; }
+
+        // Argument serialization.
+        template <typename Type> inline size_t Encodedsize(const Type &Value)
+        {
+            if constexpr (std::is_same_v<Type, const char *> || std::is_same_v<Type, char *>)
+                return sizeof(uint8_t) + sizeof(uint32_t) + (Value ? std::strlen(Value) : 0);
+            else if constexpr (std::is_convertible_v<const Type &, std::string_view>)
+                return sizeof(uint8_t) + sizeof(uint32_t) + std::string_view(Value).size();
+            else
+                return sizeof(uint8_t) + sizeof(uint64_t);
+        }
+        template <typename Type> inline uint8_t *Encode(uint8_t *Pointer, const Type &Value)
+        {
+            auto Writestring = [&](const char *String, uint32_t Length) -> uint8_t *
+            {
+                *Pointer++ = BL_STRING;
+                std::memcpy(Pointer, &Length, sizeof(uint32_t));
+                if (Length) std::memcpy(Pointer + sizeof(uint32_t), String, Length);
+                return Pointer + sizeof(uint32_t) + Length;
+            };
+            auto Writeword = [&](Argumentkind Kind, uint64_t Word) -> uint8_t *
+            {
+                *Pointer++ = Kind;
+                std::memcpy(Pointer, &Word, sizeof(uint64_t));
+                return Pointer + sizeof(uint64_t);
+            };
+
+            if constexpr (std::is_same_v<Type, const char *> || std::is_same_v<Type, char *>)
+                return Writestring(Value, Value ? uint32_t(std::strlen(Value)) : 0);
+            else if constexpr (std::is_convertible_v<const Type &, std::string_view>)
+                return Writestring(std::string_view(Value).data(), uint32_t(std::string_view(Value).size()));
+            else if constexpr (std::is_floating_point_v<Type>)
+            {
+                double Float = double(Value);
+                uint64_t Word; std::memcpy(&Word, &Float, sizeof(uint64_t));
+                return Writeword(BL_FLOAT, Word);
+            }
+            else if constexpr (std::is_pointer_v<Type>)
+                return Writeword(BL_POINTER, uint64_t(size_t(Value)));
+            else if constexpr (std::is_enum_v<Type>)
+                return Writeword(BL_SINT, uint64_t(int64_t(Value)));
+            else if constexpr (std::is_signed_v<Type>)
+                return Writeword(BL_SINT, uint64_t(int64_t(Value)));
+            else
+                return Writeword(BL_UINT, uint64_t(Value));
+        }
+    }
+
+    // Append a message to the threads buffer, no formatting is done.
+    template <typename ... Args>
+    inline void Record(uint32_t Formatid, char Level, const char *Format, const Args & ... Arguments)
+    {
+        (void)Format;
+        size_t Payloadsize = (size_t(0) + ... + Internal::Encodedsize(Arguments));
+
+        Recordheader Header;
+        Header.Kind = BL_MESSAGE;
+        Header.Level = uint8_t(Level);
+        Header.Argumentcount = uint16_t(sizeof...(Args));
+        Header.Formatid = Formatid;
+        Header.Threadid = Internal::Threadid();
+        Header.Payloadsize = uint32_t(Payloadsize);
+        Header.Timestamp = uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count());
+
+        uint8_t *Pointer = Internal::Reserve(sizeof(Recordheader) + Payloadsize);
+        std::memcpy(Pointer, &Header, sizeof(Recordheader));
+        Pointer += sizeof(Recordheader);
+        ((Pointer = Internal::Encode(Pointer, Arguments)), ...);
+        Internal::Commit(sizeof(Recordheader) + Payloadsize);
+    }
+}
@@ -8,8 +8,25 @@
 
 #include "../Stdinclude.hpp"
 
+// SSE2 is part of the x64 baseline.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define BYTEBUFFER_SSE2
+#endif
+
+static inline uint32_t Bitscanforward(uint32_t Value)
+{
+    #if defined(_WIN32)
+        unsigned long Index;
+        _BitScanForward(&Index, Value);
+        return Index;
+    #else
+        return __builtin_ctz(Value);
+    #endif
+}
+
 // Core functionality.
-bool Bytebuffer::Readdatatype(Bytebuffertype Type)
+bool Bytebufferview::Readdatatype(Bytebuffertype Type)
 {
     if (Type == Peek())
         return Setposition(Getposition() + 1);
@@ -19,13 +36,13 @@ bool Bytebuffer::Writedatatype(Bytebuffertype Type)
 {
     return Rawwrite(sizeof(uint8_t), &Type);
 }
-bool Bytebuffer::Rawread(size_t Readcount, void *Buffer)
+bool Bytebufferview::Rawread(size_t Readcount, void *Buffer)
 {
     // Rangecheck, we do not do truncated reads as they are a pain to debug.
     if ((Internaliterator + Readcount) > Internalsize) return false;
 
     // Copy the data into the new buffer if provided.
-    if (Buffer) std::memcpy(Buffer, Internalbuffer.get() + Internaliterator, Readcount);
+    if (Buffer) std::memcpy(Buffer, Internalview + Internaliterator, Readcount);
 
     // Advance the internal iterator.
     Internaliterator += Readcount;
@@ -33,26 +50,154 @@ bool Bytebuffer::Rawread(size_t Readcount, void *Buffer)
 }
 bool Bytebuffer::Rawwrite(size_t Writecount, const void *Buffer)
 {
-    // If we are at the end of the buffer, increase it.
-    if (Internaliterator == Internalsize)
+    // If we write past the end of the buffer, increase it.
+    if ((Internaliterator + Writecount) > Internalsize)
     {
-        auto Newbuffer = std::make_unique<uint8_t[]>(Internalsize + Writecount);
-        std::memmove(Newbuffer.get(), Internalbuffer.get(), Internalsize);
-        Internalbuffer.swap(Newbuffer);
-        Internalsize += Writecount;
+        // Grow geometrically so appending N fields is amortized O(N).
+        if ((Internaliterator + Writecount) > Internalcapacity)
+            Reserve(std::max(Internaliterator + Writecount, std::max(Internalcapacity * 2, size_t(64))));
+
+        // Appended space without data is zeroed.
+        if (!Buffer) std::memset(Internalbuffer.get() + Internalsize, 0, Internaliterator + Writecount - Internalsize);
+        Internalsize = Internaliterator + Writecount;
     }
 
-    // If the buffer is already large enough, overwrite.
-    if ((Internaliterator + Writecount) <= Internalsize)
+    // Write straight into the storage.
+    if (Buffer) std::memcpy(Internalbuffer.get() + Internaliterator, Buffer, Writecount);
+    Internaliterator += Writecount;
+    return true;
+}
+
+// Varint helpers, returns the number of bytes consumed or 0 if malformed.
+size_t Bytebufferview::Decodevarint(const uint8_t *Input, size_t Available, uint64_t &Value)
+{
+    Value = 0;
+    for (size_t i = 0; i < Available && i < 10; ++i)
     {
-        if(Buffer) std::memcpy(Internalbuffer.get() + Internaliterator, Buffer, Writecount);
-        Internaliterator += Writecount;
-        return true;
+        Value |= uint64_t(Input[i] & 0x7F) << (7 * i);
+        if (!(Input[i] & 0x80)) return i + 1;
+    }
+
+    return 0;
+}
+template <typename Type> size_t Bytebufferview::Decodevarints(const uint8_t *Input, size_t Available, Type *Output, size_t Count)
+{
+    const uint8_t *Start = Input, *End = Input + Available;
+    auto Store = [](uint64_t Value) -> Type
+    {
+        if constexpr (std::is_signed_v<Type>) return Type(int64_t(Value >> 1) ^ -int64_t(Value & 1));
+        else return Type(Value);
+    };
+
+    while (Count)
+    {
+        #if defined(BYTEBUFFER_SSE2)
+        // Small values are single-byte varints, so widen every byte before the first continuation.
+        if (Count >= 16 && End - Input >= 16)
+        {
+            __m128i Block = _mm_loadu_si128((const __m128i *)Input);
+            uint32_t Continuations = uint32_t(_mm_movemask_epi8(Block));
+            size_t Singlebytes = Continuations ? size_t(Bitscanforward(Continuations)) : 16;
+
+            for (size_t i = 0; i < Singlebytes; ++i) Output[i] = Store(Input[i]);
+            Output += Singlebytes; Input += Singlebytes; Count -= Singlebytes;
+            if (Singlebytes == 16) continue;
+        }
+        #endif
+
+        uint64_t Value;
+        size_t Length = Decodevarint(Input, End - Input, Value);
+        if (!Length) return 0;
+
+        *Output++ = Store(Value);
+        Input += Length;
+        --Count;
+    }
+
+    return Input - Start;
+}
+template <typename Type> bool Bytebuffer::Writevarints(const Type *Data, size_t Count)
+{
+    constexpr size_t Maxlength = (sizeof(Type) * 8 + 6) / 7;
+
+    // Reserve for the worst case and encode straight into the storage.
+    if (Internaliterator + Count * Maxlength > Internalcapacity)
+        Reserve(std::max(Internaliterator + Count * Maxlength, std::max(Internalcapacity * 2, size_t(64))));
+
+    uint8_t *Pointer = Internalbuffer.get() + Internaliterator;
+    for (size_t i = 0; i < Count; ++i)
+    {
+        // LEB128, 7 bits per byte with the high bit set on all but the last.
+        uint64_t Value;
+        if constexpr (std::is_signed_v<Type>) Value = (uint64_t(Data[i]) << 1) ^ uint64_t(int64_t(Data[i]) >> 63);
+        else Value = uint64_t(Data[i]);
+
+        while (Value >= 0x80)
+        {
+            *Pointer++ = uint8_t(Value | 0x80);
+            Value >>= 7;
+        }
+        *Pointer++ = uint8_t(Value);
     }
 
-    // Else we need to make an overwrite and an append call.
-    size_t Overwritecount = Internalsize - Internaliterator;
-    return Rawwrite(Overwritecount, Buffer) && Rawwrite(Writecount - Overwritecount, Buffer ? (uint8_t *)Buffer + Overwritecount : Buffer);
+    Internaliterator = Pointer - Internalbuffer.get();
+    Internalsize = std::max(Internalsize, Internaliterator);
+    return true;
+}
+template <typename Type> bool Bytebufferview::Readvarints(Type *Data, size_t Count)
+{
+    if (!Count) return true;
+
+    size_t Length = Decodevarints(Internalview + Internaliterator, Internalsize - Internaliterator, Data, Count);
+    Internaliterator += Length;
+    return Length != 0;
+}
+#define VARINT_TEMPLATE(Type)                                                           \
+template bool Bytebuffer::Writevarints(const Type *Data, size_t Count);                 \
+template bool Bytebufferview::Readvarints(Type *Data, size_t Count);                    \
+
+// Every wider integral type the schemas accept, the fixed-width ones alias these.
+VARINT_TEMPLATE(short);
+VARINT_TEMPLATE(unsigned short);
+VARINT_TEMPLATE(int);
+VARINT_TEMPLATE(unsigned int);
+VARINT_TEMPLATE(long);
+VARINT_TEMPLATE(unsigned long);
+VARINT_TEMPLATE(long long);
+VARINT_TEMPLATE(unsigned long long);
+VARINT_TEMPLATE(wchar_t);
+VARINT_TEMPLATE(char16_t);
+VARINT_TEMPLATE(char32_t);
+
+// Views the memory in place, it needs to outlive the view.
+Bytebufferview::Bytebufferview(const std::vector<uint8_t> &Data, size_t Prefixsize)
+    : Bytebufferview(std::min(Prefixsize, Data.size()), Data.data()) {}
+Bytebufferview::Bytebufferview(size_t Datasize, const void *Databuffer)
+{
+    Internalview = (const uint8_t *)Databuffer;
+    Internalsize = Datasize;
+    Internaliterator = 0;
+
+    Deserialize();
+}
+Bytebufferview::Bytebufferview(const std::vector<uint8_t> &Data)
+    : Bytebufferview(Data.size(), Data.data()) {}
+Bytebufferview::Bytebufferview(const Bytebufferview &Right)
+{
+    Internaliterator = Right.Internaliterator;
+    Internalcompact = Right.Internalcompact;
+    Internalview = Right.Internalview;
+    Internalsize = Right.Internalsize;
+
+    Deserialize();
+}
+Bytebufferview::Bytebufferview(std::string_view Data)
+    : Bytebufferview(Data.size(), Data.data()) {}
+Bytebufferview::Bytebufferview()
+{
+    Internalview = nullptr;
+    Internaliterator = 0;
+    Internalsize = 0;
 }
 
 // Creates the internal state.
@@ -60,8 +205,10 @@ Bytebuffer::Bytebuffer(size_t Datasize, const void *Databuffer)
 {
     Internaliterator = 0;
     Internalsize = Datasize;
+    Internalcapacity = Datasize;
     Internalbuffer = std::make_unique<uint8_t[]>(Internalsize);
     std::memcpy(Internalbuffer.get(), Databuffer, Internalsize);
+    Internalview = Internalbuffer.get();
 
     Deserialize();
 }
@@ -69,8 +216,10 @@ void Bytebuffer::Setbuffer(std::vector<uint8_t> &Data)
 {
     Internaliterator = 0;
     Internalsize = Data.size();
+    Internalcapacity = Data.size();
     Internalbuffer = std::make_unique<uint8_t[]>(Internalsize);
     std::memcpy(Internalbuffer.get(), Data.data(), Internalsize);
+    Internalview = Internalbuffer.get();
 
     Deserialize();
 }
@@ -78,12 +227,15 @@ Bytebuffer::Bytebuffer(std::vector<uint8_t> &Data)
 {
     Setbuffer(Data);
 }
-Bytebuffer::Bytebuffer(const Bytebuffer &Right)
+Bytebuffer::Bytebuffer(const Bytebuffer &Right) : Bytebufferview()
 {
     Internalbuffer = std::make_unique<uint8_t[]>(Right.Internalsize);
     std::memcpy(Internalbuffer.get(), Right.Internalbuffer.get(), Right.Internalsize);
+    Internalview = Internalbuffer.get();
 
     Internaliterator = Right.Internaliterator;
+    Internalcapacity = Right.Internalsize;
+    Internalcompact = Right.Internalcompact;
     Internalsize = Right.Internalsize;
 
     Internalvariables.clear();
@@ -93,19 +245,26 @@ void Bytebuffer::Setbuffer(std::string &Data)
 {
     Internaliterator = 0;
     Internalsize = Data.size();
+    Internalcapacity = Data.size();
     Internalbuffer = std::make_unique<uint8_t[]>(Internalsize);
     std::memcpy(Internalbuffer.get(), Data.data(), Internalsize);
+    Internalview = Internalbuffer.get();
 
     Deserialize();
 }
 Bytebuffer::Bytebuffer(Bytebuffer &&Right)
 {
+    Internalcapacity = std::exchange(Right.Internalcapacity, NULL);
     Internaliterator = std::exchange(Right.Internaliterator, NULL);
     Internalbuffer = std::exchange(Right.Internalbuffer, nullptr);
     Internalsize = std::exchange(Right.Internalsize, NULL);
+    Internalcompact = Right.Internalcompact;
+    Internalview = Internalbuffer.get();
+    Right.Internalview = nullptr;
 
-    Internalvariables.clear();
-    Deserialize();
+    // The variables point into the buffer and arena, both keep their addresses.
+    Internalvariables = std::exchange(Right.Internalvariables, {});
+    Internalarena = std::exchange(Right.Internalarena, {});
 }
 Bytebuffer::Bytebuffer(std::string &Data)
 {
@@ -113,23 +272,25 @@ Bytebuffer::Bytebuffer(std::string &Data)
 }
 Bytebuffer::Bytebuffer()
 {
-    Internalbuffer = std::make_unique<uint8_t []>(0);
+    Internalbuffer = nullptr;
+    Internalview = nullptr;
+    Internalcapacity = 0;
     Internaliterator = 0;
     Internalsize = 0;
 }
 
 // Access the internal state.
-bool Bytebuffer::Setposition(size_t Newposition)
+bool Bytebufferview::Setposition(size_t Newposition)
 {
     if (Newposition > Internalsize) return false;
     Internaliterator = Newposition;
     return true;
 }
-const size_t Bytebuffer::Getposition()
+const size_t Bytebufferview::Getposition()
 {
     return Internaliterator;
 }
-std::string Bytebuffer::to_string()
+std::string Bytebufferview::to_string()
 {
     std::string Result = "{\n";
 
@@ -139,31 +300,44 @@ std::string Bytebuffer::to_string()
 
         switch (Item.first)
         {
-            case Bytebuffertype::BB_BOOL: Result += va("bool = %s;\n", *(bool *)Item.second ? "true" : "false"); break;
-            case Bytebuffertype::BB_SINT8: Result += va("int8_t = %i;\n", *(int8_t *)Item.second); break;
-            case Bytebuffertype::BB_UINT8: Result += va("uint8_t = 0x%02X;\n", *(uint8_t *)Item.second); break;
-            case Bytebuffertype::BB_SINT16: Result += va("int16_t = %i;\n", *(int16_t *)Item.second); break;
-            case Bytebuffertype::BB_UINT16: Result += va("uint16_t = 0x%04X;\n", *(uint16_t *)Item.second); break;
-            case Bytebuffertype::BB_SINT32: Result += va("int32_t = %i;\n", *(int32_t *)Item.second); break;
-            case Bytebuffertype::BB_UINT32: Result += va("uint32_t = 0x%X;\n", *(uint32_t *)Item.second); break;
-            case Bytebuffertype::BB_SINT64: Result += va("int64_t = %lli;\n", *(int64_t *)Item.second); break;
-            case Bytebuffertype::BB_UINT64: Result += va("uint64_t = 0x%llX;\n", *(uint64_t *)Item.second); break;
-
-            case Bytebuffertype::BB_FLOAT32: Result += va("float = %f;\n", *(float *)Item.second); break;
-            case Bytebuffertype::BB_FLOAT64: Result += va("double = %f;\n", *(double *)Item.second); break;
-
-            case Bytebuffertype::BB_STRING_WIDE: Result += va("std::wstring = \"%ls\";\n", ((std::wstring *)Item.second)->c_str()); break;
-            case Bytebuffertype::BB_STRING_ASCII: Result += va("std::string = \"%s\";\n", ((std::string *)Item.second)->c_str()); break;
+            case Bytebuffertype::BB_BOOL: vaappend(Result, "bool = %s;\n", *(bool *)Item.second ? "true" : "false"); break;
+            case Bytebuffertype::BB_SINT8: vaappend(Result, "int8_t = %i;\n", *(int8_t *)Item.second); break;
+            case Bytebuffertype::BB_UINT8: vaappend(Result, "uint8_t = 0x%02X;\n", *(uint8_t *)Item.second); break;
+            case Bytebuffertype::BB_SINT16: vaappend(Result, "int16_t = %i;\n", *(int16_t *)Item.second); break;
+            case Bytebuffertype::BB_UINT16: vaappend(Result, "uint16_t = 0x%04X;\n", *(uint16_t *)Item.second); break;
+            case Bytebuffertype::BB_SINT32: vaappend(Result, "int32_t = %i;\n", *(int32_t *)Item.second); break;
+            case Bytebuffertype::BB_UINT32: vaappend(Result, "uint32_t = 0x%X;\n", *(uint32_t *)Item.second); break;
+            case Bytebuffertype::BB_SINT64: vaappend(Result, "int64_t = %lli;\n", *(int64_t *)Item.second); break;
+            case Bytebuffertype::BB_UINT64: vaappend(Result, "uint64_t = 0x%llX;\n", *(uint64_t *)Item.second); break;
+
+            case Bytebuffertype::BB_FLOAT32: vaappend(Result, "float = %f;\n", *(float *)Item.second); break;
+            case Bytebuffertype::BB_FLOAT64: vaappend(Result, "double = %f;\n", *(double *)Item.second); break;
+
+            case Bytebuffertype::BB_STRING_WIDE:
+            {
+                auto String = (std::wstring_view *)Item.second;
+                vaappend(Result, "std::wstring = \"%.*ls\";\n", int(String->size()), String->data());
+                break;
+            }
+            case Bytebuffertype::BB_STRING_ASCII:
+            {
+                auto String = (std::string_view *)Item.second;
+                vaappend(Result, "std::string = \"%.*s\";\n", int(String->size()), String->data());
+                break;
+            }
 
             case Bytebuffertype::BB_BLOB:
-                Result += va("std::array<uint8_t>[%u] = { \"", ((std::string *)Item.second)->size());
-                for (size_t i = 0; i < ((std::string *)Item.second)->size(); ++i)
-                    Result += va("\\x%02X", ((std::string *)Item.second)->at(i));
+            {
+                auto Blob = (std::string_view *)Item.second;
+                vaappend(Result, "std::array<uint8_t>[%zu] = { \"", Blob->size());
+                for (size_t i = 0; i < Blob->size(); ++i)
+                    vaappend(Result, "\\x%02X", uint8_t(Blob->at(i)));
                 Result += "\" };\n";
                 break;
+            }
 
             // NONE, MAX
-            default: Result += va("Type_%i = NULL;\n", Item.first); break;
+            default: vaappend(Result, "Type_%i = NULL;\n", Item.first); break;
         }
 
         return Result;
@@ -181,30 +355,31 @@ std::string Bytebuffer::to_string()
         // Collection.
         if(Item.first == BB_ARRAY)
         {
-            Result += va("\tstd::array<T>[%u] = \n\t{\n", ((std::vector<Type_t> *)Item.second)->size());
+            auto Array = (Array_t *)Item.second;
+            vaappend(Result, "\tstd::array<T>[%zu] = \n\t{\n", Array->Count);
 
-            for (auto &Entry : *((std::vector<Type_t> *)Item.second))
+            for (size_t i = 0; i < Array->Count; ++i)
             {
                 Result += "\t";
-                Result += Localprint(Entry);
+                Result += Localprint(Array->Items[i]);
             }
 
             Result += "\t}\n";
             continue;
         }
 
-        Result += va("Type_%i = NULL;\n", Item.first);
+        vaappend(Result, "Type_%i = NULL;\n", Item.first);
         break;
     }
 
     Result += "}";
     return Result;
 }
-const uint8_t *Bytebuffer::Data()
+const uint8_t *Bytebufferview::Data()
 {
-    return Internalbuffer.get();
+    return Internalview;
 }
-const uint8_t Bytebuffer::Peek()
+const uint8_t Bytebufferview::Peek()
 {
     uint8_t Byte = uint8_t(-1);
 
@@ -217,67 +392,128 @@ const uint8_t Bytebuffer::Peek()
 
     return Byte;
 }
-const size_t Bytebuffer::Size()
+const size_t Bytebufferview::Size()
 {
     return Internalsize;
 }
-void Bytebuffer::Deserialize()
+void Bytebufferview::Deserialize()
 {
-    uint8_t *Localpointer = Internalbuffer.get();
+    const uint8_t *Localpointer = Internalview;
     size_t Localiterator = 0;
     uint8_t Localtype = 0;
+    bool Malformed = false;
 
-    // Clear any old data.
+    // Clear any old data, the storage is reused.
     Internalvariables.clear();
-    Internalvariables.shrink_to_fit();
+    Internalarena.Reset();
 
-    auto Localread = [&](uint8_t Type) -> Type_t
+    // Lengths and counts are varints in compact buffers.
+    auto Localcount = [&](uint32_t &Count) -> bool
     {
-        switch (Bytebuffertype(Type))
+        if (Localiterator >= Internalsize) return false;
+        if (Internalcompact)
         {
-            case Bytebuffertype::BB_BOOL: return { BB_BOOL, Localpointer + Localiterator };
-            case Bytebuffertype::BB_SINT8: return { BB_SINT8, Localpointer + Localiterator };
-            case Bytebuffertype::BB_UINT8: return { BB_UINT8, Localpointer + Localiterator };
-            case Bytebuffertype::BB_SINT16: return { BB_SINT16, Localpointer + Localiterator };
-            case Bytebuffertype::BB_UINT16: return { BB_UINT16, Localpointer + Localiterator };
-            case Bytebuffertype::BB_SINT32: return { BB_SINT32, Localpointer + Localiterator };
-            case Bytebuffertype::BB_UINT32: return { BB_UINT32, Localpointer + Localiterator };
-            case Bytebuffertype::BB_SINT64: return { BB_SINT64, Localpointer + Localiterator };
-            case Bytebuffertype::BB_UINT64: return { BB_UINT64, Localpointer + Localiterator };
-            case Bytebuffertype::BB_FLOAT32: return { BB_FLOAT32, Localpointer + Localiterator };
-            case Bytebuffertype::BB_FLOAT64: return { BB_FLOAT64, Localpointer + Localiterator };
-            case Bytebuffertype::BB_STRING_WIDE: return { BB_STRING_WIDE, new std::wstring((wchar_t *)(Localpointer + Localiterator)) };
-            case Bytebuffertype::BB_STRING_ASCII: return { BB_STRING_ASCII, new std::string((char *)(Localpointer + Localiterator)) };
-
-            default: break;
+            size_t Length = Decodevarints(Localpointer + Localiterator, Internalsize - Localiterator, &Count, 1);
+            Localiterator += Length;
+            return Length != 0;
         }
 
-        return { BB_NONE, nullptr };
+        if (Localiterator + sizeof(uint32_t) > Internalsize) return false;
+        std::memcpy(&Count, Localpointer + Localiterator, sizeof(uint32_t));
+        Localiterator += sizeof(uint32_t);
+        return true;
     };
-    auto Localincrement = [&](uint8_t Type) -> void
+
+    // Every variable is bounds-checked, a malformed buffer yields no variables.
+    auto Localread = [&](uint8_t Type) -> Type_t
     {
+        size_t Remaining = Internalsize - Localiterator;
+        auto Fixedsize = [&](Bytebuffertype Fixedtype, size_t Size) -> Type_t
+        {
+            if (Size > Remaining) { Malformed = true; return { BB_NONE, nullptr }; }
+            Localiterator += Size;
+            return { Fixedtype, (void *)(Localpointer + Localiterator - Size) };
+        };
+        auto Integer = [&](Bytebuffertype Integertype, auto *Typed) -> Type_t
+        {
+            using Integer_t = std::remove_pointer_t<decltype(Typed)>;
+            if (!Internalcompact) return Fixedsize(Integertype, sizeof(Integer_t));
+
+            // Decoded into the arena as the buffer holds the varint.
+            auto Value = Internalarena.Create<Integer_t>();
+            size_t Length = Decodevarints(Localpointer + Localiterator, Remaining, Value, 1);
+            if (!Length) { Malformed = true; return { BB_NONE, nullptr }; }
+            Localiterator += Length;
+            return { Integertype, Value };
+        };
+
         switch (Bytebuffertype(Type))
         {
-            case Bytebuffertype::BB_BOOL: Localiterator += sizeof(bool); break;
-            case Bytebuffertype::BB_SINT8: Localiterator += sizeof(int8_t); break;
-            case Bytebuffertype::BB_UINT8: Localiterator += sizeof(uint8_t); break;
-            case Bytebuffertype::BB_SINT16: Localiterator += sizeof(int16_t); break;
-            case Bytebuffertype::BB_UINT16: Localiterator += sizeof(uint16_t); break;
-            case Bytebuffertype::BB_SINT32: Localiterator += sizeof(int32_t); break;
-            case Bytebuffertype::BB_UINT32: Localiterator += sizeof(uint32_t); break;
-            case Bytebuffertype::BB_SINT64: Localiterator += sizeof(int64_t); break;
-            case Bytebuffertype::BB_UINT64: Localiterator += sizeof(uint64_t); break;
-            case Bytebuffertype::BB_FLOAT32: Localiterator += sizeof(float); break;
-            case Bytebuffertype::BB_FLOAT64: Localiterator += sizeof(double); break;
-
-            case Bytebuffertype::BB_STRING_ASCII: Localiterator += std::strlen((char *)(Localpointer + Localiterator)) + sizeof(char); break;
-            case Bytebuffertype::BB_STRING_WIDE: Localiterator += std::wcslen((wchar_t *)(Localpointer + Localiterator)) * sizeof(wchar_t) + sizeof(wchar_t); break;
+            case Bytebuffertype::BB_BOOL: return Fixedsize(BB_BOOL, sizeof(bool));
+            case Bytebuffertype::BB_SINT8: return Fixedsize(BB_SINT8, sizeof(int8_t));
+            case Bytebuffertype::BB_UINT8: return Fixedsize(BB_UINT8, sizeof(uint8_t));
+            case Bytebuffertype::BB_SINT16: return Integer(BB_SINT16, (int16_t *)nullptr);
+            case Bytebuffertype::BB_UINT16: return Integer(BB_UINT16, (uint16_t *)nullptr);
+            case Bytebuffertype::BB_SINT32: return Integer(BB_SINT32, (int32_t *)nullptr);
+            case Bytebuffertype::BB_UINT32: return Integer(BB_UINT32, (uint32_t *)nullptr);
+            case Bytebuffertype::BB_SINT64: return Integer(BB_SINT64, (int64_t *)nullptr);
+            case Bytebuffertype::BB_UINT64: return Integer(BB_UINT64, (uint64_t *)nullptr);
+            case Bytebuffertype::BB_FLOAT32: return Fixedsize(BB_FLOAT32, sizeof(float));
+            case Bytebuffertype::BB_FLOAT64: return Fixedsize(BB_FLOAT64, sizeof(double));
+
+            case Bytebuffertype::BB_STRING_ASCII:
+            {
+                if (Internalcompact)
+                {
+                    uint32_t Length;
+                    if (!Localcount(Length) || Length > Internalsize - Localiterator) break;
+
+                    Localiterator += Length;
+                    return { BB_STRING_ASCII, Internalarena.Create<std::string_view>((const char *)(Localpointer + Localiterator - Length), size_t(Length)) };
+                }
+
+                auto String = (const char *)(Localpointer + Localiterator);
+                auto Terminator = (const char *)std::memchr(String, '\0', Remaining);
+                if (!Terminator) break;
+
+                Localiterator += (Terminator - String) + sizeof(char);
+                return { BB_STRING_ASCII, Internalarena.Create<std::string_view>(String, size_t(Terminator - String)) };
+            }
+            case Bytebuffertype::BB_STRING_WIDE:
+            {
+                if (Internalcompact)
+                {
+                    uint32_t Length;
+                    if (!Localcount(Length) || size_t(Length) * sizeof(wchar_t) > Internalsize - Localiterator) break;
+
+                    Localiterator += size_t(Length) * sizeof(wchar_t);
+                    return { BB_STRING_WIDE, Internalarena.Create<std::wstring_view>((const wchar_t *)(Localpointer + Localiterator) - Length, size_t(Length)) };
+                }
+
+                auto String = (const wchar_t *)(Localpointer + Localiterator);
+                size_t Length = 0;
+                wchar_t Character = 1;
+
+                while ((Length + 1) * sizeof(wchar_t) <= Remaining)
+                {
+                    std::memcpy(&Character, String + Length, sizeof(wchar_t));
+                    if (Character == L'\0') break;
+                    ++Length;
+                }
+                if (Character != L'\0') break;
+
+                Localiterator += (Length + 1) * sizeof(wchar_t);
+                return { BB_STRING_WIDE, Internalarena.Create<std::wstring_view>(String, Length) };
+            }
 
             default: break;
         }
+
+        Malformed = true;
+        return { BB_NONE, nullptr };
     };
 
-    while (Localiterator < Internalsize)
+    while (Localiterator < Internalsize && !Malformed)
     {
         Localtype = *(Localpointer + Localiterator);
         Localiterator += sizeof(uint8_t);
@@ -286,22 +522,21 @@ void Bytebuffer::Deserialize()
         if (Localtype >= BB_BOOL && Localtype <= BB_STRING_ASCII)
         {
             Internalvariables.push_back(Localread(Localtype));
-            Localincrement(Localtype);
             continue;
         }
 
         // Collection.
         if (Localtype >= BB_BOOL + 100 && Localtype <= BB_STRING_ASCII + 100)
         {
-            uint32_t Arraysize = *(uint32_t *)(Localpointer + Localiterator);
-            auto Arraydata = new std::vector<Type_t>();
-            Localiterator += sizeof(uint32_t);
+            uint32_t Arraysize;
+            if (!Localcount(Arraysize)) break;
 
-            for (uint32_t i = 0; i < Arraysize; ++i)
-            {
-                Arraydata->push_back(Localread(Localtype - 100));
-                Localincrement(Localtype - 100);
-            }
+            // Every element is at least a byte, so the size can be validated before allocating.
+            if (Arraysize > Internalsize - Localiterator) break;
+
+            auto Arraydata = Internalarena.Create<Array_t>((Type_t *)Internalarena.Allocate(sizeof(Type_t) * Arraysize), size_t(Arraysize));
+            for (uint32_t i = 0; i < Arraysize && !Malformed; ++i)
+                Arraydata->Items[i] = Localread(Localtype - 100);
 
             Internalvariables.push_back({ BB_ARRAY, Arraydata });
             continue;
@@ -310,11 +545,14 @@ void Bytebuffer::Deserialize()
         // Blob data.
         if (Localtype == BB_BLOB)
         {
+            // The size keeps its own type-tag.
+            uint32_t Blobsize;
+            if (Localiterator >= Internalsize) break;
             Localiterator += sizeof(uint8_t);
-            uint32_t Blobsize = *(uint32_t *)(Localpointer + Localiterator);
-            Localiterator += sizeof(uint32_t);
+            if (!Localcount(Blobsize)) break;
 
-            Internalvariables.push_back({ BB_BLOB, new std::string((char *)(Localpointer + Localiterator), Blobsize) });
+            if (Blobsize > Internalsize - Localiterator) break;
+            Internalvariables.push_back({ BB_BLOB, Internalarena.Create<std::string_view>((const char *)(Localpointer + Localiterator), size_t(Blobsize)) });
             Localiterator += Blobsize;
             continue;
         }
@@ -322,33 +560,114 @@ void Bytebuffer::Deserialize()
         break;
     }
 
-    if (Localiterator != Internalsize)
+    if (Malformed || Localiterator != Internalsize)
     {
         Internalvariables.clear();
-        Internalvariables.shrink_to_fit();
+        Internalarena.Reset();
     }
 }
-void Bytebuffer::Rewind()
+void Bytebufferview::Rewind()
 {
     Internaliterator = 0;
 }
 void Bytebuffer::Clear()
 {
-    Internalbuffer = std::make_unique<uint8_t[]>(0);
+    Internalvariables.clear();
+    Internalarena.Reset();
     Internaliterator = 0;
     Internalsize = 0;
 }
 
+// Compact encoding, both peers need to agree on the mode.
+void Bytebufferview::Setcompact(bool Enabled)
+{
+    if (Internalcompact == Enabled) return;
+
+    Internalcompact = Enabled;
+    if (Internalsize) Deserialize();
+}
+const bool Bytebufferview::Iscompact()
+{
+    return Internalcompact;
+}
+
+// Storage management, writes grow the storage geometrically.
+const size_t Bytebuffer::Capacity()
+{
+    return Internalcapacity;
+}
+const size_t Bytebuffer::Storagesize()
+{
+    return Internalcapacity + Internalarena.Blockstotal + Internalvariables.capacity() * sizeof(Type_t);
+}
+void Bytebuffer::Reserve(size_t Newcapacity)
+{
+    if (Newcapacity <= Internalcapacity) return;
+
+    // The new storage is left uninitialized, Rawwrite fills it.
+    auto Newbuffer = std::unique_ptr<uint8_t[]>(new uint8_t[Newcapacity]);
+    if (Internalsize) std::memcpy(Newbuffer.get(), Internalbuffer.get(), Internalsize);
+    Internalbuffer.swap(Newbuffer);
+    Internalview = Internalbuffer.get();
+    Internalcapacity = Newcapacity;
+}
+void Bytebuffer::Shrinktofit()
+{
+    if (Internalcapacity == Internalsize) return;
+
+    auto Newbuffer = Internalsize ? std::unique_ptr<uint8_t[]>(new uint8_t[Internalsize]) : nullptr;
+    if (Internalsize) std::memcpy(Newbuffer.get(), Internalbuffer.get(), Internalsize);
+    Internalbuffer.swap(Newbuffer);
+    Internalview = Internalbuffer.get();
+    Internalcapacity = Internalsize;
+
+    // Deserialized variables pointed into the old storage.
+    Internalvariables.clear();
+    Internalarena.Reset();
+}
+
+// Bump-allocator for deserialized variables, keeps its largest block on Reset.
+void *Bytebuffer::Arena_t::Allocate(size_t Size)
+{
+    constexpr size_t Alignment = alignof(std::max_align_t);
+    Size = (Size + Alignment - 1) & ~(Alignment - 1);
+
+    if (Blocks.empty() || Blockused + Size > Blocksize)
+    {
+        Blocksize = std::max(std::max(Blocksize * 2, Size), size_t(4096));
+        Blocks.emplace_back(new uint8_t[Blocksize]);
+        Blockstotal += Blocksize;
+        Blockused = 0;
+    }
+
+    Blockused += Size;
+    return Blocks.back().get() + Blockused - Size;
+}
+void Bytebuffer::Arena_t::Reset()
+{
+    if (Blocks.size() > 1)
+    {
+        auto Largest = std::move(Blocks.back());
+        Blocks.clear();
+        Blocks.push_back(std::move(Largest));
+        Blockstotal = Blocksize;
+    }
+
+    Blockused = 0;
+}
+
 // Single data IO.
 #pragma region SINGLE_IO
 #define SINGLE_TEMPLATE(Type, Enum)                                         \
-template <> bool Bytebuffer::Read(Type &Buffer, bool Typechecked)           \
+template <> bool Bytebufferview::Read(Type &Buffer, bool Typechecked)       \
 {                                                                           \
-    if(!Typechecked || Readdatatype(Enum))                                  \
-        return Rawread(sizeof(Buffer), &Buffer);                            \
-    else return false;                                                      \
+    if (Typechecked && !Readdatatype(Enum)) return false;                   \
+                                                                            \
+    if constexpr (Bytebufferschema::Isvarint<Type>) if (Internalcompact)    \
+        return Readvarints(&Buffer, 1);                                     \
+    return Rawread(sizeof(Buffer), &Buffer);                                \
 }                                                                           \
-template <> Type Bytebuffer::Read(bool Typechecked)                         \
+template <> Type Bytebufferview::Read(bool Typechecked)                     \
 {                                                                           \
     Type Result{};                                                          \
     Read(Result, Typechecked);                                              \
@@ -357,6 +676,9 @@ template <> Type Bytebuffer::Read(bool Typechecked)                         \
 template <> bool Bytebuffer::Write(const Type Buffer, bool Typechecked)     \
 {                                                                           \
     if(Typechecked) Writedatatype(Enum);                                    \
+                                                                            \
+    if constexpr (Bytebufferschema::Isvarint<Type>) if (Internalcompact)    \
+        return Writevarints(&Buffer, 1);                                    \
     return Rawwrite(sizeof(Buffer), &Buffer);                               \
 }                                                                           \
 
@@ -373,17 +695,36 @@ SINGLE_TEMPLATE(uint64_t, BB_UINT64);
 SINGLE_TEMPLATE(float, BB_FLOAT32);
 SINGLE_TEMPLATE(double, BB_FLOAT64);
 
-template <> bool Bytebuffer::Read(std::string &Buffer, bool Typechecked)
+template <> bool Bytebufferview::Read(std::string &Buffer, bool Typechecked)
 {
-    if (!Typechecked || Readdatatype(BB_STRING_ASCII))
+    if (Typechecked && !Readdatatype(BB_STRING_ASCII)) return false;
+    auto String = (const char *)Data() + Internaliterator;
+
+    // Compact strings are length-prefixed without the terminator.
+    if (Internalcompact)
     {
-        size_t Stringlength = std::strlen((const char *)Data() + Internaliterator) + 1;
-        Buffer.append((const char *)Data() + Internaliterator);
-        return Setposition(Getposition() + Stringlength);
+        size_t Startposition = Internaliterator;
+        uint32_t Length = 0;
+
+        if (!Read(Length, false) || Length > Internalsize - Internaliterator)
+        {
+            Internaliterator = Startposition;
+            return false;
+        }
+
+        Buffer.append((const char *)Data() + Internaliterator, Length);
+        Internaliterator += Length;
+        return true;
     }
-    return false;
+
+    auto Terminator = (const char *)std::memchr(String, '\0', Internalsize - Internaliterator);
+    if (!Terminator) return false;
+
+    Buffer.append(String, Terminator - String);
+    Internaliterator += (Terminator - String) + 1;
+    return true;
 }
-template <> std::string Bytebuffer::Read(bool Typechecked)
+template <> std::string Bytebufferview::Read(bool Typechecked)
 {
     std::string Result{};
     Read(Result, Typechecked);
@@ -392,20 +733,49 @@ template <> std::string Bytebuffer::Read(bool Typechecked)
 template <> bool Bytebuffer::Write(const std::string Buffer, bool Typechecked)
 {
     if(Typechecked) Writedatatype(BB_STRING_ASCII);
+
+    if (Internalcompact)
+        return Write(uint32_t(Buffer.size()), false) && Rawwrite(Buffer.size(), Buffer.data());
     return Rawwrite(Buffer.size() + 1, Buffer.c_str());
 }
 
-template <> bool Bytebuffer::Read(std::wstring &Buffer, bool Typechecked)
+template <> bool Bytebufferview::Read(std::wstring &Buffer, bool Typechecked)
 {
-    if (!Typechecked || Readdatatype(BB_STRING_WIDE))
+    if (Typechecked && !Readdatatype(BB_STRING_WIDE)) return false;
+    size_t Startposition = Internaliterator;
+    size_t Length = 0;
+
+    // Compact strings are length-prefixed without the terminator.
+    if (Internalcompact)
+    {
+        uint32_t Storedlength = 0;
+        if (!Read(Storedlength, false) || size_t(Storedlength) * sizeof(wchar_t) > Internalsize - Internaliterator)
+        {
+            Internaliterator = Startposition;
+            return false;
+        }
+        Length = Storedlength;
+    }
+    else
     {
-        size_t Stringlength = std::wcslen((const wchar_t *)(Data() + Internaliterator)) + 1;
-        Buffer.append((const wchar_t *)(Data() + Internaliterator));
-        return Setposition(Getposition() + Stringlength * sizeof(wchar_t));
+        // The buffer may not be aligned for wchar_t.
+        wchar_t Character = 1;
+        while ((Length + 1) * sizeof(wchar_t) <= Internalsize - Internaliterator)
+        {
+            std::memcpy(&Character, Data() + Internaliterator + Length * sizeof(wchar_t), sizeof(wchar_t));
+            if (Character == L'\0') break;
+            ++Length;
+        }
+        if (Character != L'\0') return false;
     }
-    return false;
+
+    size_t Offset = Buffer.size();
+    Buffer.resize(Offset + Length);
+    std::memcpy(Buffer.data() + Offset, Data() + Internaliterator, Length * sizeof(wchar_t));
+    Internaliterator += (Length + (Internalcompact ? 0 : 1)) * sizeof(wchar_t);
+    return true;
 }
-template <> std::wstring Bytebuffer::Read(bool Typechecked)
+template <> std::wstring Bytebufferview::Read(bool Typechecked)
 {
     std::wstring Result{};
     Read(Result, Typechecked);
@@ -414,27 +784,29 @@ template <> std::wstring Bytebuffer::Read(bool Typechecked)
 template <> bool Bytebuffer::Write(const std::wstring Buffer, bool Typechecked)
 {
     if (Typechecked) Writedatatype(BB_STRING_WIDE);
+
+    if (Internalcompact)
+        return Write(uint32_t(Buffer.size()), false) && Rawwrite(Buffer.size() * sizeof(wchar_t), Buffer.data());
     return Rawwrite((Buffer.size() + 1) * sizeof(wchar_t), Buffer.c_str());
 }
 
-template <> bool Bytebuffer::Read(std::vector<uint8_t> &Buffer, bool Typechecked)
+template <> bool Bytebufferview::Read(std::vector<uint8_t> &Buffer, bool Typechecked)
 {
-    if (!Typechecked || Readdatatype(BB_BLOB))
-    {
-        uint32_t Bloblength = Read<uint32_t>();
-        auto Localbuffer = std::make_unique<uint8_t[]>(Bloblength);
-
-        if (Rawread(Bloblength, Localbuffer.get()))
-        {
-            for (uint32_t i = 0; i < Bloblength; ++i)
-                Buffer.push_back(Localbuffer[i]);
+    if (Typechecked && !Readdatatype(BB_BLOB)) return false;
+    size_t Startposition = Internaliterator;
+    uint32_t Bloblength = 0;
 
-            return true;
-        }
+    if (!Read(Bloblength) || Bloblength > Internalsize - Internaliterator)
+    {
+        Internaliterator = Startposition;
+        return false;
     }
-    return false;
+
+    Buffer.insert(Buffer.end(), Data() + Internaliterator, Data() + Internaliterator + Bloblength);
+    Internaliterator += Bloblength;
+    return true;
 }
-template <> std::vector<uint8_t> Bytebuffer::Read(bool Typechecked)
+template <> std::vector<uint8_t> Bytebufferview::Read(bool Typechecked)
 {
     std::vector<uint8_t> Result{};
     Read(Result, Typechecked);
@@ -459,38 +831,116 @@ template <> bool Bytebuffer::Write(const wchar_t *Buffer, bool Typechecked)
 
 // Multiple data IO.
 #pragma region MULTIPLE_IO
-#define MULTI_TEMPLATE(Type, Enum)                                          \
-template <> bool Bytebuffer::Readarray(std::vector<Type> &Data)             \
-{                                                                           \
-    uint8_t Storedtype = Read<uint8_t>(false);                              \
-    if (Storedtype != Enum + 100) return false;                             \
-                                                                            \
-    uint32_t Storedcount = Read<uint32_t>(false);                           \
-    for (; Storedcount; --Storedcount)                                      \
-        Data.push_back({ Read<Type>(false) });                              \
-    return true;                                                            \
-}                                                                           \
-template <> bool Bytebuffer::Writearray(std::vector<Type> Data)             \
-{                                                                           \
-    Write(uint8_t(Enum + 100), false);                                      \
-    Write(uint32_t(Data.size()), false);                                    \
-                                                                            \
-    for (auto Item : Data) Write(Type(Item), false);                        \
-    return true;                                                            \
-}                                                                           \
+// Reverse the bytes of each element for peers with another byte-order.
+template <typename Type> static void Swapelements(void *Data, size_t Count)
+{
+    auto Pointer = (uint8_t *)Data;
+    for (size_t i = 0; i < Count; ++i, Pointer += sizeof(Type))
+        std::reverse(Pointer, Pointer + sizeof(Type));
+}
+
+// Trivially copyable types are stored as a single block.
+#define POD_MULTI_TEMPLATE(Type, Enum)                                                  \
+template <> bool Bytebufferview::Readarray(std::vector<Type> &Data, bool Byteswap)      \
+{                                                                                       \
+    size_t Startposition = Internaliterator;                                            \
+    uint32_t Storedcount = 0;                                                           \
+                                                                                        \
+    constexpr bool Varint = Bytebufferschema::Isvarint<Type>;                           \
+    size_t Elementsize = Varint && Internalcompact ? 1 : sizeof(Type);                  \
+                                                                                        \
+    if (Read<uint8_t>(false) != Enum + 100 || !Read(Storedcount, false) ||              \
+        size_t(Storedcount) * Elementsize > Internalsize - Internaliterator)            \
+    {                                                                                   \
+        Internaliterator = Startposition;                                               \
+        return false;                                                                   \
+    }                                                                                   \
+                                                                                        \
+    size_t Offset = Data.size();                                                        \
+    Data.resize(Offset + Storedcount);                                                  \
+                                                                                        \
+    /* Varints are byte-order independent. */                                           \
+    if constexpr (Varint) if (Internalcompact)                                          \
+    {                                                                                   \
+        if (Readvarints(Data.data() + Offset, Storedcount)) return true;                \
+        Data.resize(Offset);                                                            \
+        Internaliterator = Startposition;                                               \
+        return false;                                                                   \
+    }                                                                                   \
+                                                                                        \
+    Rawread(Storedcount * sizeof(Type), Data.data() + Offset);                          \
+    if (Byteswap) Swapelements<Type>(Data.data() + Offset, Storedcount);                \
+    return true;                                                                        \
+}                                                                                       \
+template <> bool Bytebuffer::Writearray(const Type *Data, size_t Count, bool Byteswap)  \
+{                                                                                       \
+    Write(uint8_t(Enum + 100), false);                                                  \
+    Write(uint32_t(Count), false);                                                      \
+                                                                                        \
+    if constexpr (Bytebufferschema::Isvarint<Type>) if (Internalcompact)                \
+        return Writevarints(Data, Count);                                               \
+                                                                                        \
+    size_t Offset = Internaliterator;                                                   \
+    if (!Rawwrite(Count * sizeof(Type), Data)) return false;                            \
+    if (Byteswap) Swapelements<Type>(Internalbuffer.get() + Offset, Count);             \
+    return true;                                                                        \
+}                                                                                       \
+template <> bool Bytebuffer::Writearray(const std::vector<Type> &Data, bool Byteswap)   \
+{                                                                                       \
+    return Writearray(Data.data(), Data.size(), Byteswap);                              \
+}                                                                                       \
+
+// Other types are stored element by element.
+#define MULTI_TEMPLATE(Type, Enum)                                                      \
+template <> bool Bytebufferview::Readarray(std::vector<Type> &Data, bool Byteswap)      \
+{                                                                                       \
+    size_t Startposition = Internaliterator;                                            \
+    uint32_t Storedcount = 0;                                                           \
+    (void)Byteswap;                                                                     \
+                                                                                        \
+    if (Read<uint8_t>(false) != Enum + 100 || !Read(Storedcount, false) ||              \
+        size_t(Storedcount) > Internalsize - Internaliterator)                          \
+    {                                                                                   \
+        Internaliterator = Startposition;                                               \
+        return false;                                                                   \
+    }                                                                                   \
+                                                                                        \
+    Data.reserve(Data.size() + Storedcount);                                            \
+    for (; Storedcount; --Storedcount)                                                  \
+        Data.push_back({ Read<Type>(false) });                                          \
+    return true;                                                                        \
+}                                                                                       \
+template <> bool Bytebuffer::Writearray(const Type *Data, size_t Count, bool Byteswap)  \
+{                                                                                       \
+    (void)Byteswap;                                                                     \
+    Write(uint8_t(Enum + 100), false);                                                  \
+    Write(uint32_t(Count), false);                                                      \
+                                                                                        \
+    for (size_t i = 0; i < Count; ++i) Write(Type(Data[i]), false);                     \
+    return true;                                                                        \
+}                                                                                       \
+template <> bool Bytebuffer::Writearray(const std::vector<Type> &Data, bool Byteswap)   \
+{                                                                                       \
+    (void)Byteswap;                                                                     \
+    Write(uint8_t(Enum + 100), false);                                                  \
+    Write(uint32_t(Data.size()), false);                                                \
+                                                                                        \
+    for (const auto &Item : Data) Write(Type(Item), false);                             \
+    return true;                                                                        \
+}                                                                                       \
 
 MULTI_TEMPLATE(bool, BB_BOOL);
-MULTI_TEMPLATE(char, BB_SINT8);
-MULTI_TEMPLATE(int8_t, BB_SINT8);
-MULTI_TEMPLATE(uint8_t, BB_UINT8);
-MULTI_TEMPLATE(int16_t, BB_SINT16);
-MULTI_TEMPLATE(uint16_t, BB_UINT16);
-MULTI_TEMPLATE(int32_t, BB_SINT32);
-MULTI_TEMPLATE(uint32_t, BB_UINT32);
-MULTI_TEMPLATE(int64_t, BB_SINT64);
-MULTI_TEMPLATE(uint64_t, BB_UINT64);
-MULTI_TEMPLATE(float, BB_FLOAT32);
-MULTI_TEMPLATE(double, BB_FLOAT64);
+POD_MULTI_TEMPLATE(char, BB_SINT8);
+POD_MULTI_TEMPLATE(int8_t, BB_SINT8);
+POD_MULTI_TEMPLATE(uint8_t, BB_UINT8);
+POD_MULTI_TEMPLATE(int16_t, BB_SINT16);
+POD_MULTI_TEMPLATE(uint16_t, BB_UINT16);
+POD_MULTI_TEMPLATE(int32_t, BB_SINT32);
+POD_MULTI_TEMPLATE(uint32_t, BB_UINT32);
+POD_MULTI_TEMPLATE(int64_t, BB_SINT64);
+POD_MULTI_TEMPLATE(uint64_t, BB_UINT64);
+POD_MULTI_TEMPLATE(float, BB_FLOAT32);
+POD_MULTI_TEMPLATE(double, BB_FLOAT64);
 
 MULTI_TEMPLATE(std::string, BB_STRING_ASCII);
 MULTI_TEMPLATE(std::wstring, BB_STRING_WIDE);
@@ -549,10 +999,16 @@ Bytebuffer &Bytebuffer::operator = (const Bytebuffer &Right) noexcept
 {
     if (this != &Right)
     {
-        if(Internalsize != Right.Internalsize) Internalbuffer = std::make_unique<uint8_t[]>(Right.Internalsize);
-        std::memcpy(Internalbuffer.get(), Right.Internalbuffer.get(), Right.Internalsize);
+        if (Internalcapacity < Right.Internalsize)
+        {
+            Internalbuffer = std::make_unique<uint8_t[]>(Right.Internalsize);
+            Internalview = Internalbuffer.get();
+            Internalcapacity = Right.Internalsize;
+        }
+        if (Right.Internalsize) std::memcpy(Internalbuffer.get(), Right.Internalbuffer.get(), Right.Internalsize);
 
         Internaliterator = Right.Internaliterator;
+        Internalcompact = Right.Internalcompact;
         Internalsize = Right.Internalsize;
 
         Internalvariables.clear();
@@ -565,11 +1021,30 @@ Bytebuffer &Bytebuffer::operator = (Bytebuffer &&Right) noexcept
 {
     if (this != &Right)
     {
+        Internalcapacity = std::exchange(Right.Internalcapacity, NULL);
         Internaliterator = std::exchange(Right.Internaliterator, NULL);
         Internalbuffer = std::exchange(Right.Internalbuffer, nullptr);
         Internalsize = std::exchange(Right.Internalsize, NULL);
+        Internalcompact = Right.Internalcompact;
+        Internalview = Internalbuffer.get();
+        Right.Internalview = nullptr;
+
+        // The variables point into the buffer and arena, both keep their addresses.
+        Internalvariables = std::exchange(Right.Internalvariables, {});
+        Internalarena = std::exchange(Right.Internalarena, {});
+    }
+
+    return *this;
+}
+Bytebufferview &Bytebufferview::operator = (const Bytebufferview &Right) noexcept
+{
+    if (this != &Right)
+    {
+        Internaliterator = Right.Internaliterator;
+        Internalcompact = Right.Internalcompact;
+        Internalview = Right.Internalview;
+        Internalsize = Right.Internalsize;
 
-        Internalvariables.clear();
         Deserialize();
     }
 
@@ -580,9 +1055,113 @@ bool Bytebuffer::operator == (const Bytebuffer &Right) noexcept
     if (Internalsize != Right.Internalsize) return false;
     return 0 == std::memcmp(Internalbuffer.get(), Right.Internalbuffer.get(), Internalsize);
 }
-Bytebuffer::Type_t &Bytebuffer::operator [](size_t Index) noexcept
+Bytebufferview::Type_t &Bytebufferview::operator [](size_t Index) noexcept
 {
     static Type_t Defaultvalue = { Bytebuffertype::BB_NONE, nullptr };
     if (Internalvariables.size() < Index) return Defaultvalue;
     else return Internalvariables[Index];
 }
+
+// Thread-caching pool where released buffers keep their storage.
+namespace Bytebufferpool
+{
+    struct Threadcache
+    {
+        std::vector<Bytebuffer *> Buffers;
+        size_t Limit{ BYTEBUFFER_POOL_LIMIT };
+        size_t Retained{};
+
+        ~Threadcache();
+    };
+    static thread_local Threadcache Localcache;
+    static thread_local bool Cachedestroyed{};
+    constexpr size_t Maxbuffers = 64;
+
+    Threadcache::~Threadcache()
+    {
+        for (auto &Buffer : Buffers) delete Buffer;
+        Cachedestroyed = true;
+    }
+
+    // Handles released from other thread_local destructors can outlive the cache.
+    static Threadcache *Cache()
+    {
+        return Cachedestroyed ? nullptr : &Localcache;
+    }
+
+    void Release::operator()(Bytebuffer *Buffer) const noexcept
+    {
+        if (!Buffer) return;
+
+        // Buffers are cached by the thread that releases them.
+        auto Localcache = Cache();
+        if (!Localcache)
+        {
+            delete Buffer;
+            return;
+        }
+
+        // Cleared first so only the storage that is kept counts.
+        Buffer->Clear();
+        Buffer->Setcompact(false);
+
+        size_t Storage = Buffer->Storagesize();
+        if (Localcache->Retained + Storage > Localcache->Limit || Localcache->Buffers.size() >= Maxbuffers)
+        {
+            delete Buffer;
+            return;
+        }
+
+        Localcache->Retained += Storage;
+        Localcache->Buffers.push_back(Buffer);
+    }
+
+    // Take a cleared buffer from the current threads cache, the handle returns it.
+    Handle_t Acquire(size_t Minimumcapacity)
+    {
+        auto Localcache = Cache();
+        if (!Localcache || Localcache->Buffers.empty())
+        {
+            Handle_t Result(new Bytebuffer());
+            if (Minimumcapacity) Result->Reserve(Minimumcapacity);
+            return Result;
+        }
+
+        // The most recently released buffer is the most likely to be in cache.
+        Handle_t Result(Localcache->Buffers.back());
+        Localcache->Buffers.pop_back();
+        Localcache->Retained -= Result->Storagesize();
+
+        Result->Reserve(Minimumcapacity);
+        return Result;
+    }
+
+    // Bytes of storage the current thread keeps, larger buffers are freed on release.
+    void Setretainlimit(size_t Bytes)
+    {
+        auto Localcache = Cache();
+        if (!Localcache) return;
+
+        Localcache->Limit = Bytes;
+        while (Localcache->Retained > Localcache->Limit)
+        {
+            Localcache->Retained -= Localcache->Buffers.front()->Storagesize();
+            delete Localcache->Buffers.front();
+            Localcache->Buffers.erase(Localcache->Buffers.begin());
+        }
+    }
+    const size_t Retainedsize()
+    {
+        auto Localcache = Cache();
+        return Localcache ? Localcache->Retained : 0;
+    }
+    void Trim()
+    {
+        auto Localcache = Cache();
+        if (!Localcache) return;
+
+        for (auto &Buffer : Localcache->Buffers) delete Buffer;
+        Localcache->Buffers.clear();
+        Localcache->Retained = 0;
+    }
+}
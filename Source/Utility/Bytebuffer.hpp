@@ -4,13 +4,17 @@
     License: MIT
     Notes:
         Provides fast and simple storage for messages.
+        Bytebufferview reads messages in place from memory
+        owned by someone else, such as a receive stream.
+        Bytebufferpool recycles buffers and their storage.
 */
 
 #pragma once
 #include "../Stdinclude.hpp"
 
-class Bytebuffer
+class Bytebufferview
 {
+protected:
     // The types of data that can be handled.
     enum Bytebuffertype : uint8_t
     {
@@ -34,30 +38,62 @@ class Bytebuffer
     };
 
     // Generic storage-types.
+    // Numbers point into the buffer, strings and blobs are std::(w)string_view
+    // and arrays are Array_t, all allocated from the arena until Clear().
     using Type_t = std::pair<Bytebuffertype, void *>;
+    struct Array_t { Type_t *Items; size_t Count; };
 
-    // Internal state properties.
-    std::unique_ptr<uint8_t[]> Internalbuffer;
+    // Bump-allocator for deserialized variables, keeps its largest block on Reset.
+    struct Arena_t
+    {
+        std::vector<std::unique_ptr<uint8_t[]>> Blocks;
+        size_t Blockused{}, Blocksize{}, Blockstotal{};
+
+        void *Allocate(size_t Size);
+        template <typename Type, typename ... Args> Type *Create(Args && ... Arguments)
+        {
+            static_assert(std::is_trivially_destructible_v<Type>, "The arena never runs destructors.");
+            return new (Allocate(sizeof(Type))) Type{ std::forward<Args>(Arguments)... };
+        }
+        void Reset();
+    };
+
+    // Internal state properties, the data is owned by someone else.
+    const uint8_t *Internalview;
     std::vector<Type_t> Internalvariables;
+    Arena_t Internalarena;
     size_t Internaliterator;
     size_t Internalsize;
+    bool Internalcompact{};
 
     // Core functionality.
     bool Readdatatype(Bytebuffertype Type);                         // Compares the next byte with the input.
-    bool Writedatatype(Bytebuffertype Type);                        // Writes the input as the next byte.
     bool Rawread(size_t Readcount, void *Buffer = nullptr);         // Reads from the internal buffer.
-    bool Rawwrite(size_t Writecount, const void *Buffer = nullptr); // Writes to the internal buffer.
+
+    // Compact encoding, LEB128 varints with zigzag for signed types.
+    template <typename Type> bool Readvarints(Type *Data, size_t Count);
+    static size_t Decodevarint(const uint8_t *Input, size_t Available, uint64_t &Value);
+    template <typename Type> static size_t Decodevarints(const uint8_t *Input, size_t Available, Type *Output, size_t Count);
+
+    // Schema helpers, see Bytebufferschema.hpp.
+    template <typename Type> static constexpr Bytebuffertype Schematag();
+    template <typename Type> bool Readschemafield(Type &Value, bool Typechecked);
 
 public:
-    // Creates the internal state.
-    Bytebuffer(size_t Datasize, const void *Databuffer);
-    void Setbuffer(std::vector<uint8_t> &Data);
-    Bytebuffer(std::vector<uint8_t> &Data);
-    Bytebuffer(const Bytebuffer &Right);
-    void Setbuffer(std::string &Data);
-    Bytebuffer(Bytebuffer &&Right);
-    Bytebuffer(std::string &Data);
-    Bytebuffer();
+    // Views the memory in place, it needs to outlive the view.
+    Bytebufferview(const std::vector<uint8_t> &Data, size_t Prefixsize);
+    Bytebufferview(size_t Datasize, const void *Databuffer);
+    Bytebufferview(const std::vector<uint8_t> &Data);
+    Bytebufferview(const Bytebufferview &Right);
+    Bytebufferview(Bytebufferview &&Right) = default;
+    Bytebufferview(std::string_view Data);
+    Bytebufferview();
+
+    // Views never own their data, so temporaries would dangle.
+    Bytebufferview(std::vector<uint8_t> &&Data, size_t Prefixsize) = delete;
+    Bytebufferview(std::vector<uint8_t> &&Data) = delete;
+    template <typename Type, typename = std::enable_if_t<std::is_same_v<Type, std::string>>>
+    Bytebufferview(Type &&Data) = delete;
 
     // Access the internal state.
     bool Setposition(size_t Newposition);                           // Sets the internal read/write iterator.
@@ -68,16 +104,69 @@ public:
     const size_t Size();                                            // Returns the size of the current buffer.
     void Deserialize();                                             // Deserialize the buffer into variables.
     void Rewind();                                                  // Resets the internal read/write iterator.
-    void Clear();                                                   // Clears the internal buffer.
+
+    // Compact mode stores wide integers, lengths and counts as varints
+    // and strings without terminators, both peers need to use the same mode.
+    void Setcompact(bool Enabled);                                  // Selects the encoding, re-deserializes the buffer.
+    const bool Iscompact();                                         // Returns the current encoding.
 
     // Single data IO.
     template <typename Type> Type Read(bool Typechecked = true);
     template <typename Type> bool Read(Type &Buffer, bool Typechecked = true);
+
+    // Multiple data IO, arithmetic types are copied as a single block.
+    // Byteswap reverses each element for peers with another byte-order.
+    template <typename Type> bool Readarray(std::vector<Type> &Data, bool Byteswap = false);
+
+    // Compile-time schemas for structs declaring BYTEBUFFER_SCHEMA, see Bytebufferschema.hpp.
+    template <typename Struct> bool Readschema(Struct &Value, bool Typechecked = true);
+
+    // Supported operators, acts on the internal state.
+    Bytebufferview &operator = (const Bytebufferview &Right) noexcept;
+    Type_t &operator [](size_t Index) noexcept;
+};
+
+class Bytebuffer : public Bytebufferview
+{
+    // Internal state properties, Internalview points into the storage.
+    std::unique_ptr<uint8_t[]> Internalbuffer;
+    size_t Internalcapacity;
+
+    // Core functionality.
+    bool Writedatatype(Bytebuffertype Type);                        // Writes the input as the next byte.
+    bool Rawwrite(size_t Writecount, const void *Buffer = nullptr); // Writes to the internal buffer.
+    template <typename Type> bool Writevarints(const Type *Data, size_t Count);
+    template <typename Type> bool Writeschemafield(const Type &Value, bool Typechecked);
+
+public:
+    // Creates the internal state.
+    Bytebuffer(size_t Datasize, const void *Databuffer);
+    void Setbuffer(std::vector<uint8_t> &Data);
+    Bytebuffer(std::vector<uint8_t> &Data);
+    Bytebuffer(const Bytebuffer &Right);
+    void Setbuffer(std::string &Data);
+    Bytebuffer(Bytebuffer &&Right);
+    Bytebuffer(std::string &Data);
+    Bytebuffer();
+
+    // Access the internal state.
+    void Clear();                                                   // Clears the internal buffer, keeps the storage.
+
+    // Storage management, writes grow the storage geometrically.
+    const size_t Capacity();                                        // Returns the size of the storage.
+    const size_t Storagesize();                                     // Returns the storage including deserialized variables.
+    void Reserve(size_t Newcapacity);                               // Grows the storage to at least Newcapacity.
+    void Shrinktofit();                                             // Releases storage past the current size.
+
+    // Single data IO.
     template <typename Type> bool Write(const Type Value, bool Typechecked = true);
 
-    // Multiple data IO.
-    template <typename Type> bool Readarray(std::vector<Type> &Data);
-    template <typename Type> bool Writearray(std::vector<Type> Data);
+    // Multiple data IO, arithmetic types are copied as a single block.
+    template <typename Type> bool Writearray(const std::vector<Type> &Data, bool Byteswap = false);
+    template <typename Type> bool Writearray(const Type *Data, size_t Count, bool Byteswap = false);
+
+    // Typechecked = false omits the per-field tags for trusted peers.
+    template <typename Struct> bool Writeschema(const Struct &Value, bool Typechecked = true);
 
     // Direct IO.
     template <typename Type> Bytebuffer &operator += (const Type &Right) noexcept;
@@ -91,5 +180,19 @@ public:
     Bytebuffer &operator = (const Bytebuffer &Right) noexcept;
     Bytebuffer &operator = (Bytebuffer &&Right) noexcept;
     bool operator == (const Bytebuffer &Right) noexcept;
-    Type_t &operator [](size_t Index) noexcept;
 };
+
+// Thread-caching pool where released buffers keep their storage.
+namespace Bytebufferpool
+{
+    struct Release { void operator()(Bytebuffer *Buffer) const noexcept; };
+    using Handle_t = std::unique_ptr<Bytebuffer, Release>;
+
+    // Take a cleared buffer from the current threads cache, the handle returns it.
+    Handle_t Acquire(size_t Minimumcapacity = 0);
+
+    // Bytes of storage the current thread keeps, larger buffers are freed on release.
+    void Setretainlimit(size_t Bytes);
+    const size_t Retainedsize();
+    void Trim();
+}
@@ -0,0 +1,200 @@
+/*
+    Initial author: Convery (tcn@hedgehogscience.com)
+    Started: 19-10-2026
+    License: MIT
+    Notes:
+        Compile-time serialization of structs that list their
+        fields with BYTEBUFFER_SCHEMA(...), the leading fixed-size
+        fields are laid out at compile-time and checked at once
+        unless the buffer is compact.
+*/
+
+#pragma once
+#include "../Stdinclude.hpp"
+
+namespace Bytebufferschema
+{
+    // Type traits for the field types.
+    template <typename Type, typename = void> struct Hasschema : std::false_type {};
+    template <typename Type> struct Hasschema<Type, std::void_t<decltype(std::declval<Type &>().Schemafields())>> : std::true_type {};
+    template <typename Type> struct Isvector : std::false_type {};
+    template <typename Type> struct Isvector<std::vector<Type>> : std::true_type {};
+    template <typename Type> constexpr bool Isfixed = std::is_arithmetic_v<Type> || std::is_enum_v<Type>;
+    template <typename Type, bool = std::is_enum_v<Type>> struct Integer { using type = Type; };
+    template <typename Type> struct Integer<Type, true> { using type = std::underlying_type_t<Type>; };
+    template <typename Type> using Integer_t = typename Integer<Type>::type;
+    template <typename Type> constexpr bool Isvarint = std::is_integral_v<Integer_t<Type>> && sizeof(Type) > 1;
+    template <typename Tuple, size_t Index> using Field_t = std::decay_t<std::tuple_element_t<Index, Tuple>>;
+
+    // Number of leading fixed-size fields and their combined size.
+    template <typename Tuple, size_t Index = 0> constexpr size_t Prefixcount()
+    {
+        if constexpr (Index == std::tuple_size_v<Tuple>) return Index;
+        else if constexpr (Isfixed<Field_t<Tuple, Index>>) return Prefixcount<Tuple, Index + 1>();
+        else return Index;
+    }
+    template <typename Tuple, size_t ... Index> constexpr size_t Prefixsize(std::index_sequence<Index...>)
+    {
+        return (size_t(0) + ... + sizeof(Field_t<Tuple, Index>));
+    }
+
+    // Visit the fields [Offset, Offset + Count), stops at the first failure.
+    template <size_t Offset, typename Tuple, typename Function, size_t ... Index>
+    inline bool Foreach(Tuple &Fields, Function &&Callback, std::index_sequence<Index...>)
+    {
+        return (Callback(std::get<Offset + Index>(Fields)) && ...);
+    }
+}
+
+// Tags match the ones used by Write<Type>.
+template <typename Type> constexpr Bytebufferview::Bytebuffertype Bytebufferview::Schematag()
+{
+    if constexpr (std::is_enum_v<Type>) return Schematag<std::underlying_type_t<Type>>();
+    else if constexpr (std::is_same_v<Type, bool>) return BB_BOOL;
+    else if constexpr (std::is_floating_point_v<Type>) return sizeof(Type) == sizeof(float) ? BB_FLOAT32 : BB_FLOAT64;
+    else if constexpr (sizeof(Type) == 1) return std::is_signed_v<Type> ? BB_SINT8 : BB_UINT8;
+    else if constexpr (sizeof(Type) == 2) return std::is_signed_v<Type> ? BB_SINT16 : BB_UINT16;
+    else if constexpr (sizeof(Type) == 4) return std::is_signed_v<Type> ? BB_SINT32 : BB_UINT32;
+    else return std::is_signed_v<Type> ? BB_SINT64 : BB_UINT64;
+}
+
+// Fields after the prefix go through the normal API.
+template <typename Type> bool Bytebuffer::Writeschemafield(const Type &Value, bool Typechecked)
+{
+    if constexpr (Bytebufferschema::Hasschema<Type>::value)
+        return Writeschema(Value, Typechecked);
+    else if constexpr (Bytebufferschema::Isfixed<Type>)
+    {
+        if (Typechecked) Writedatatype(Schematag<Type>());
+
+        if constexpr (Bytebufferschema::Isvarint<Type>) if (Internalcompact)
+        {
+            auto Integer = Bytebufferschema::Integer_t<Type>(Value);
+            return Writevarints(&Integer, 1);
+        }
+        return Rawwrite(sizeof(Type), &Value);
+    }
+    else if constexpr (std::is_same_v<Type, std::vector<uint8_t>>)
+        return Write(Value, Typechecked);
+    else if constexpr (Bytebufferschema::Isvector<Type>::value)
+        return Writearray(Value);
+    else
+        return Write(Value, Typechecked);
+}
+template <typename Type> bool Bytebufferview::Readschemafield(Type &Value, bool Typechecked)
+{
+    if constexpr (Bytebufferschema::Hasschema<Type>::value)
+        return Readschema(Value, Typechecked);
+    else if constexpr (Bytebufferschema::Isfixed<Type>)
+    {
+        if (Typechecked && !Readdatatype(Schematag<Type>())) return false;
+
+        if constexpr (Bytebufferschema::Isvarint<Type>) if (Internalcompact)
+        {
+            Bytebufferschema::Integer_t<Type> Integer{};
+            if (!Readvarints(&Integer, 1)) return false;
+            Value = Type(Integer);
+            return true;
+        }
+        return Rawread(sizeof(Type), &Value);
+    }
+    else if constexpr (std::is_same_v<Type, std::vector<uint8_t>>)
+    {
+        Value.clear();
+        return Read(Value, Typechecked);
+    }
+    else if constexpr (Bytebufferschema::Isvector<Type>::value)
+    {
+        Value.clear();
+        return Readarray(Value);
+    }
+    else
+    {
+        Value.clear();
+        return Read(Value, Typechecked);
+    }
+}
+
+// Serialize the struct, the fixed-size prefix is a single write.
+template <typename Struct> bool Bytebuffer::Writeschema(const Struct &Value, bool Typechecked)
+{
+    static_assert(Bytebufferschema::Hasschema<Struct>::value, "Declare the fields with BYTEBUFFER_SCHEMA(...)");
+    using Fields_t = decltype(Value.Schemafields());
+    constexpr size_t Fieldcount = std::tuple_size_v<Fields_t>;
+    constexpr size_t Prefixcount = Bytebufferschema::Prefixcount<Fields_t>();
+    constexpr size_t Prefixsize = Bytebufferschema::Prefixsize<Fields_t>(std::make_index_sequence<Prefixcount>());
+    auto Fields = Value.Schemafields();
+
+    // Compact fields vary in size, so there is no fixed prefix.
+    if (Internalcompact)
+    {
+        return Bytebufferschema::Foreach<0>(Fields, [&](const auto &Field)
+        {
+            return Writeschemafield(Field, Typechecked);
+        }, std::make_index_sequence<Fieldcount>());
+    }
+
+    // Extend the buffer once and copy the prefix in place.
+    size_t Offset = Internaliterator;
+    if (!Rawwrite(Prefixsize + (Typechecked ? Prefixcount : 0))) return false;
+    uint8_t *Pointer = Internalbuffer.get() + Offset;
+
+    Bytebufferschema::Foreach<0>(Fields, [&](const auto &Field)
+    {
+        using Type = std::decay_t<decltype(Field)>;
+        if (Typechecked) *Pointer++ = Schematag<Type>();
+        std::memcpy(Pointer, &Field, sizeof(Type));
+        Pointer += sizeof(Type);
+        return true;
+    }, std::make_index_sequence<Prefixcount>());
+
+    return Bytebufferschema::Foreach<Prefixcount>(Fields, [&](const auto &Field)
+    {
+        return Writeschemafield(Field, Typechecked);
+    }, std::make_index_sequence<Fieldcount - Prefixcount>());
+}
+
+// Deserialize the struct, the fixed-size prefix is bounds-checked once.
+template <typename Struct> bool Bytebufferview::Readschema(Struct &Value, bool Typechecked)
+{
+    static_assert(Bytebufferschema::Hasschema<Struct>::value, "Declare the fields with BYTEBUFFER_SCHEMA(...)");
+    using Fields_t = decltype(Value.Schemafields());
+    constexpr size_t Fieldcount = std::tuple_size_v<Fields_t>;
+    constexpr size_t Prefixcount = Bytebufferschema::Prefixcount<Fields_t>();
+    constexpr size_t Prefixsize = Bytebufferschema::Prefixsize<Fields_t>(std::make_index_sequence<Prefixcount>());
+    auto Fields = Value.Schemafields();
+
+    size_t Startposition = Internaliterator;
+    if (Internalcompact)
+    {
+        bool Valid = Bytebufferschema::Foreach<0>(Fields, [&](auto &Field)
+        {
+            return Readschemafield(Field, Typechecked);
+        }, std::make_index_sequence<Fieldcount>());
+
+        if (!Valid) Internaliterator = Startposition;
+        return Valid;
+    }
+
+    size_t Totalsize = Prefixsize + (Typechecked ? Prefixcount : 0);
+    if (Totalsize > Internalsize - Internaliterator) return false;
+
+    const uint8_t *Pointer = Internalview + Internaliterator;
+    bool Valid = Bytebufferschema::Foreach<0>(Fields, [&](auto &Field)
+    {
+        using Type = std::decay_t<decltype(Field)>;
+        if (Typechecked && *Pointer++ != Schematag<Type>()) return false;
+        std::memcpy(&Field, Pointer, sizeof(Type));
+        Pointer += sizeof(Type);
+        return true;
+    }, std::make_index_sequence<Prefixcount>());
+    Internaliterator += Totalsize;
+
+    Valid = Valid && Bytebufferschema::Foreach<Prefixcount>(Fields, [&](auto &Field)
+    {
+        return Readschemafield(Field, Typechecked);
+    }, std::make_index_sequence<Fieldcount - Prefixcount>());
+
+    if (!Valid) Internaliterator = Startposition;
+    return Valid;
+}
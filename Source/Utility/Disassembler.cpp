@@ -0,0 +1,312 @@
+/*
+    Initial author: Convery (tcn@hedgehogscience.com)
+    Started: 19-10-2026
+    License: MIT
+    Notes:
+        Length disassembler for x86 and x64, only decodes
+        what is needed to relocate instructions.
+*/
+
+#include "../Stdinclude.hpp"
+
+namespace Disassembler
+{
+    namespace Internal
+    {
+        #if defined(ENVIRONMENT64)
+        constexpr bool Longmode = true;
+        #else
+        constexpr bool Longmode = false;
+        #endif
+
+        // Opcodes only valid outside of long mode.
+        constexpr bool Isprotectedonly(uint8_t Opcode)
+        {
+            switch (Opcode)
+            {
+                case 0x06: case 0x07: case 0x0E: case 0x16: case 0x17: case 0x1E: case 0x1F:
+                case 0x27: case 0x2F: case 0x37: case 0x3F: case 0x60: case 0x61: case 0x62:
+                case 0x82: case 0x9A: case 0xCE: case 0xD4: case 0xD5: case 0xEA:
+                    return true;
+                default:
+                    return false;
+            }
+        }
+
+        // One-byte map, returns false for unknown opcodes.
+        bool Decodeprimary(uint8_t Opcode, bool &Hasmodrm, size_t &Immediate, size_t Wordsize, Instruction_t &Instruction)
+        {
+            // ALU rows, add through cmp.
+            if (Opcode < 0x40 && (Opcode & 7) < 6)
+            {
+                if ((Opcode & 7) < 4) Hasmodrm = true;
+                else Immediate = (Opcode & 7) == 4 ? 1 : Wordsize;
+                return true;
+            }
+
+            if (Opcode >= 0x40 && Opcode <= 0x61) return true;
+            if (Opcode >= 0x70 && Opcode <= 0x7F)
+            {
+                Instruction.Kind = REL_CONDITIONAL;
+                Instruction.Condition = Opcode & 0x0F;
+                Immediate = 1;
+                return true;
+            }
+            if (Opcode >= 0x84 && Opcode <= 0x8F) { Hasmodrm = true; return true; }
+            if (Opcode >= 0x90 && Opcode <= 0x99) return true;
+            if (Opcode >= 0xB0 && Opcode <= 0xB7) { Immediate = 1; return true; }
+            if (Opcode >= 0xD8 && Opcode <= 0xDF) { Hasmodrm = true; return true; }
+            if (Opcode >= 0xE0 && Opcode <= 0xE3)
+            {
+                Instruction.Kind = REL_LOOP;
+                Immediate = 1;
+                return true;
+            }
+
+            switch (Opcode)
+            {
+                case 0x27: case 0x2F: case 0x37: case 0x3F: case 0x06: case 0x07: case 0x0E:
+                case 0x16: case 0x17: case 0x1E: case 0x1F:
+                case 0x6C: case 0x6D: case 0x6E: case 0x6F: case 0x9B: case 0x9C: case 0x9D:
+                case 0x9E: case 0x9F: case 0xA4: case 0xA5: case 0xA6: case 0xA7: case 0xAA:
+                case 0xAB: case 0xAC: case 0xAD: case 0xAE: case 0xAF: case 0xC9: case 0xCE:
+                case 0xD7: case 0xEC: case 0xED: case 0xEE: case 0xEF: case 0xF1: case 0xF4:
+                case 0xF5: case 0xF8: case 0xF9: case 0xFA: case 0xFB: case 0xFC: case 0xFD:
+                    return true;
+
+                case 0x62: case 0x63: case 0x84: case 0xC4: case 0xC5: case 0xD0: case 0xD1:
+                case 0xD2: case 0xD3: case 0xFE: case 0xFF: case 0xF6: case 0xF7:
+                    Hasmodrm = true;
+                    return true;
+
+                case 0x6A: case 0xA8: case 0xCD: case 0xD4: case 0xD5: case 0xE4: case 0xE5:
+                case 0xE6: case 0xE7:
+                    Immediate = 1;
+                    return true;
+
+                case 0x68: case 0xA9:
+                    Immediate = Wordsize;
+                    return true;
+
+                case 0x69: case 0x81: case 0xC7:
+                    Hasmodrm = true;
+                    Immediate = Wordsize;
+                    return true;
+
+                case 0x6B: case 0x80: case 0x82: case 0x83: case 0xC0: case 0xC1: case 0xC6:
+                    Hasmodrm = true;
+                    Immediate = 1;
+                    return true;
+
+                case 0xC2: case 0xCA:
+                    Instruction.Terminator = true;
+                    Immediate = 2;
+                    return true;
+
+                case 0xC3: case 0xCB: case 0xCC: case 0xCF:
+                    Instruction.Terminator = true;
+                    return true;
+
+                case 0xC8:
+                    Immediate = 3;
+                    return true;
+
+                case 0xE8:
+                    Instruction.Kind = REL_CALL;
+                    Immediate = 4;
+                    return true;
+
+                case 0xE9: case 0xEB:
+                    Instruction.Kind = REL_JUMP;
+                    Instruction.Terminator = true;
+                    Immediate = Opcode == 0xE9 ? 4 : 1;
+                    return true;
+
+                case 0x9A: case 0xEA:
+                    Instruction.Terminator = Opcode == 0xEA;
+                    Immediate = Wordsize + 2;
+                    return true;
+
+                default:
+                    return false;
+            }
+        }
+
+        // Two-byte map, 0F xx.
+        bool Decodesecondary(uint8_t Opcode, bool &Hasmodrm, size_t &Immediate, Instruction_t &Instruction)
+        {
+            if (Opcode >= 0x80 && Opcode <= 0x8F)
+            {
+                Instruction.Kind = REL_CONDITIONAL;
+                Instruction.Condition = Opcode & 0x0F;
+                Immediate = 4;
+                return true;
+            }
+            if (Opcode >= 0x30 && Opcode <= 0x37) return true;
+            if (Opcode >= 0xC8 && Opcode <= 0xCF) return true;
+
+            switch (Opcode)
+            {
+                case 0x0B:
+                    Instruction.Terminator = true;
+                    return true;
+
+                case 0x05: case 0x06: case 0x07: case 0x08: case 0x09: case 0x0E: case 0x77:
+                case 0xA0: case 0xA1: case 0xA2: case 0xA8: case 0xA9: case 0xAA:
+                    return true;
+
+                case 0x70: case 0x71: case 0x72: case 0x73: case 0xA4: case 0xAC: case 0xBA:
+                case 0xC2: case 0xC4: case 0xC5: case 0xC6:
+                    Hasmodrm = true;
+                    Immediate = 1;
+                    return true;
+
+                // 3DNow and undefined opcodes.
+                case 0x04: case 0x0A: case 0x0C: case 0x0F: case 0x36: case 0x39: case 0x3B:
+                case 0x3C: case 0x3D: case 0x3E: case 0x3F:
+                    return false;
+
+                default:
+                    Hasmodrm = true;
+                    return true;
+            }
+        }
+    }
+
+    // Decode a single instruction, false for encodings we do not handle.
+    bool Decode(const void *Address, Instruction_t &Instruction)
+    {
+        auto Code = reinterpret_cast<const uint8_t *>(Address);
+        bool Operandsize = false, Addresssize = false, Rexw = false;
+        size_t Offset = 0;
+        Instruction = {};
+
+        // Legacy prefixes.
+        for (;; ++Offset)
+        {
+            if (Offset == 14) return false;
+
+            uint8_t Prefix = Code[Offset];
+            if (Prefix == 0x66) Operandsize = true;
+            else if (Prefix == 0x67) Addresssize = true;
+            else if (Prefix != 0xF0 && Prefix != 0xF2 && Prefix != 0xF3 && Prefix != 0x2E && Prefix != 0x36 &&
+                     Prefix != 0x3E && Prefix != 0x26 && Prefix != 0x64 && Prefix != 0x65) break;
+        }
+
+        if (Internal::Longmode && (Code[Offset] & 0xF0) == 0x40)
+        {
+            Rexw = Code[Offset] & 0x08;
+            ++Offset;
+        }
+
+        uint8_t Opcode = Code[Offset++];
+        size_t Wordsize = Operandsize ? 2 : 4;
+        uint8_t Primary = 0;
+        bool Hasmodrm = false;
+        size_t Immediate = 0;
+
+        // VEX and EVEX encoded, outside of long mode C4 / C5 / 62 are LES / LDS / BOUND unless the next byte has mod 3.
+        bool Vex = (Opcode == 0xC4 || Opcode == 0xC5) && (Internal::Longmode || (Code[Offset] & 0xC0) == 0xC0);
+        bool Evex = Opcode == 0x62 && (Internal::Longmode || (Code[Offset] & 0xC0) == 0xC0);
+        if (Vex || Evex)
+        {
+            uint8_t Map = 1;
+            if (Opcode == 0xC4) Map = Code[Offset] & 0x1F;
+            if (Opcode == 0x62) Map = Code[Offset] & 0x03;
+            Offset += Opcode == 0xC5 ? 1 : Opcode == 0xC4 ? 2 : 3;
+
+            if (Map < 1 || Map > 3) return false;
+            Opcode = Code[Offset++];
+
+            // vzeroupper / vzeroall take no operands.
+            Hasmodrm = !(Map == 1 && Opcode == 0x77);
+            if (Map == 3) Immediate = 1;
+            if (Map == 1 && ((Opcode >= 0x70 && Opcode <= 0x73) || Opcode == 0xC2 || (Opcode >= 0xC4 && Opcode <= 0xC6))) Immediate = 1;
+        }
+        else if (Opcode == 0x0F)
+        {
+            Opcode = Code[Offset++];
+
+            if (Opcode == 0x38 || Opcode == 0x3A)
+            {
+                Immediate = Opcode == 0x3A ? 1 : 0;
+                Opcode = Code[Offset++];
+                Hasmodrm = true;
+            }
+            else if (!Internal::Decodesecondary(Opcode, Hasmodrm, Immediate, Instruction)) return false;
+        }
+        else
+        {
+            if (Internal::Longmode && Internal::Isprotectedonly(Opcode)) return false;
+            Primary = Opcode;
+
+            // Memory offsets and wide immediates depend on the prefixes.
+            if (Opcode >= 0xA0 && Opcode <= 0xA3) Immediate = Internal::Longmode ? (Addresssize ? 4 : 8) : (Addresssize ? 2 : 4);
+            else if (Opcode >= 0xB8 && Opcode <= 0xBF) Immediate = Rexw ? 8 : Wordsize;
+            else if (!Internal::Decodeprimary(Opcode, Hasmodrm, Immediate, Wordsize, Instruction)) return false;
+        }
+
+        if (Hasmodrm)
+        {
+            uint8_t Modrm = Code[Offset++];
+            uint8_t Mod = Modrm >> 6, Reg = (Modrm >> 3) & 7, Rm = Modrm & 7;
+            size_t Displacement = 0;
+
+            // Group 3 test takes an immediate, group 5 has the indirect jumps.
+            if (Primary == 0xF6 && Reg < 2) Immediate = 1;
+            if (Primary == 0xF7 && Reg < 2) Immediate = Wordsize;
+            if (Primary == 0xFF && (Reg == 4 || Reg == 5)) Instruction.Terminator = true;
+
+            if (!Internal::Longmode && Addresssize)
+            {
+                if (Mod == 0 && Rm == 6) Displacement = 2;
+                if (Mod == 1) Displacement = 1;
+                if (Mod == 2) Displacement = 2;
+            }
+            else
+            {
+                if (Mod != 3 && Rm == 4 && Mod == 0 && (Code[Offset] & 7) == 5) Displacement = 4;
+                if (Mod != 3 && Rm == 4) ++Offset;
+                if (Mod == 1) Displacement = 1;
+                if (Mod == 2) Displacement = 4;
+
+                if (Mod == 0 && Rm == 5)
+                {
+                    Displacement = 4;
+
+                    if (Internal::Longmode)
+                    {
+                        Instruction.Kind = REL_MEMORY;
+                        Instruction.Displacementoffset = uint8_t(Offset);
+                        Instruction.Displacementsize = 4;
+                    }
+                }
+            }
+
+            Offset += Displacement;
+        }
+
+        // Branches keep their displacement in the immediate.
+        if (Instruction.Kind != REL_NONE && Instruction.Kind != REL_MEMORY)
+        {
+            Instruction.Displacementoffset = uint8_t(Offset);
+            Instruction.Displacementsize = uint8_t(Immediate);
+        }
+
+        Offset += Immediate;
+        if (Offset > 15) return false;
+        Instruction.Length = uint8_t(Offset);
+
+        // Resolve the target.
+        if (Instruction.Kind != REL_NONE)
+        {
+            int32_t Relative = 0;
+            if (Instruction.Displacementsize == 1) Relative = int8_t(Code[Instruction.Displacementoffset]);
+            else std::memcpy(&Relative, Code + Instruction.Displacementoffset, sizeof(int32_t));
+
+            Instruction.Target = size_t(Code) + Instruction.Length + size_t(ptrdiff_t(Relative));
+        }
+
+        return true;
+    }
+}
@@ -0,0 +1,39 @@
+/*
+    Initial author: Convery (tcn@hedgehogscience.com)
+    Started: 19-10-2026
+    License: MIT
+    Notes:
+        Length disassembler for x86 and x64, only decodes
+        what is needed to relocate instructions.
+*/
+
+#pragma once
+#include "../Stdinclude.hpp"
+
+namespace Disassembler
+{
+    // How the instruction depends on its own address.
+    enum Relativekind : uint8_t
+    {
+        REL_NONE = 0,
+        REL_JUMP,           // jmp rel8 / rel32.
+        REL_CALL,           // call rel32.
+        REL_CONDITIONAL,    // jcc rel8 / rel32, Condition is the low nibble of the opcode.
+        REL_LOOP,           // loop / jecxz rel8, can not be widened.
+        REL_MEMORY,         // RIP-relative operand, x64 only.
+    };
+
+    struct Instruction_t
+    {
+        uint8_t Length;
+        uint8_t Kind;
+        uint8_t Condition;
+        uint8_t Displacementoffset;     // Offset of the relative field.
+        uint8_t Displacementsize;
+        bool Terminator;                // Execution does not continue after the instruction.
+        size_t Target;                  // Absolute address of relative operands.
+    };
+
+    // Decode a single instruction, false for encodings we do not handle.
+    bool Decode(const void *Address, Instruction_t &Instruction);
+}
@@ -9,101 +9,804 @@
 
 #include "../Stdinclude.hpp"
 
-// Restore the memory where the hook was placed.
-bool Hooking::Stomphook::Removehook()
+// Thread enumeration.
+#if defined(_WIN32)
+    #include <TlHelp32.h>
+#else
+    #include <sys/syscall.h>
+    #include <ucontext.h>
+    #include <signal.h>
+    #include <sched.h>
+#endif
+
+// Trampolines hold the relocated instructions and a jump back.
+namespace Hooking
 {
-    auto Protection = Memprotect::Unprotectrange(Savedlocation, 20);
+    namespace Internal
     {
-        std::memcpy(Savedlocation, Savedcode, 20);
+        // Everything is within reach on x86.
+        inline bool Isnear(size_t From, size_t To)
+        {
+        #if defined(ENVIRONMENT64)
+            auto Distance = int64_t(To - From);
+            return Distance >= INT32_MIN && Distance <= INT32_MAX;
+        #else
+            return true;
+        #endif
+        }
+
+        #if defined(ENVIRONMENT64)
+        constexpr size_t Relaysize = 16, Farjumpsize = 14;
+        #else
+        constexpr size_t Relaysize = 0, Farjumpsize = 5;
+        #endif
+
+        // Trampolines are carved from blocks, near ones are placed in a free gap within reach of the hook.
+        constexpr size_t Blocksize = 64 * 1024;
+        uint8_t *Allocateblock(size_t Address)
+        {
+        #if defined(_WIN32)
+            return (uint8_t *)VirtualAlloc((void *)Address, Blocksize, MEM_COMMIT | MEM_RESERVE, PAGE_EXECUTE_READWRITE);
+        #else
+            auto Block = (uint8_t *)mmap((void *)Address, Blocksize, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (Block == MAP_FAILED) return nullptr;
+
+            // The address is only a hint.
+            if (Address && Block != (uint8_t *)Address)
+            {
+                munmap(Block, Blocksize);
+                return nullptr;
+            }
+
+            return Block;
+        #endif
+        }
+        uint8_t *Allocatenearblock(size_t Near)
+        {
+        #if !defined(ENVIRONMENT64)
+            return Allocateblock(0);
+        #else
+            const size_t Reach = size_t(INT32_MAX) - Blocksize;
+            const size_t Low = Near > Reach + Blocksize ? Near - Reach : Blocksize;
+            const size_t High = Near + Reach - Blocksize;
+
+        #if defined(_WIN32)
+            SYSTEM_INFO Info;
+            GetSystemInfo(&Info);
+            const size_t Granularity = Info.dwAllocationGranularity;
+            MEMORY_BASIC_INFORMATION Region;
+
+            // Walk the regions down from the hook, then up.
+            for (size_t Address = Near & ~(Granularity - 1); Address >= Low + Granularity;)
+            {
+                Address -= Granularity;
+                if (!VirtualQuery((void *)Address, &Region, sizeof(Region))) break;
+
+                if (Region.State == MEM_FREE) { if (auto Block = Allocateblock(Address)) return Block; }
+                else Address = size_t(Region.AllocationBase) & ~(Granularity - 1);
+            }
+            for (size_t Address = Near; Address <= High;)
+            {
+                if (!VirtualQuery((void *)Address, &Region, sizeof(Region))) break;
+
+                const size_t Candidate = (size_t(Region.BaseAddress) + Granularity - 1) & ~(Granularity - 1);
+                if (Region.State == MEM_FREE && Candidate + Blocksize <= size_t(Region.BaseAddress) + Region.RegionSize)
+                    if (auto Block = Allocateblock(Candidate)) return Block;
+
+                Address = size_t(Region.BaseAddress) + Region.RegionSize;
+            }
+
+            return nullptr;
+        #else
+            std::FILE *Filehandle = std::fopen("/proc/self/maps", "r");
+            if (!Filehandle) return nullptr;
+
+            size_t Previous = Blocksize, Best = 0, Bestdistance = SIZE_MAX, Start, End;
+            char Buffer[1024]{};
+            bool Linestart = true;
+
+            // The closest block sized gap between two mappings.
+            while (std::fgets(Buffer, 1024, Filehandle))
+            {
+                bool Parse = Linestart;
+                Linestart = std::strchr(Buffer, '\n') != nullptr;
+                if (!Parse || std::sscanf(Buffer, "%zx-%zx", &Start, &End) != 2) continue;
+
+                const size_t First = (Previous + Blocksize - 1) & ~(Blocksize - 1);
+                const size_t Last = Start >= Blocksize ? (Start - Blocksize) & ~(Blocksize - 1) : 0;
+                if (First <= Last)
+                {
+                    size_t Candidate = std::clamp(Near & ~(Blocksize - 1), First, Last);
+                    size_t Distance = Candidate > Near ? Candidate - Near : Near - Candidate;
+                    if (Candidate >= Low && Candidate <= High && Distance < Bestdistance)
+                    {
+                        Bestdistance = Distance;
+                        Best = Candidate;
+                    }
+                }
+
+                Previous = std::max(Previous, End);
+            }
+
+            std::fclose(Filehandle);
+            return Best ? Allocateblock(Best) : nullptr;
+        #endif
+        #endif
+        }
+
+        // Executable memory is never released, threads may still be running in it.
+        uint8_t *Allocatetrampoline(size_t Size, size_t Near)
+        {
+            struct Block_t { uint8_t *Current, *End; };
+            static std::vector<Block_t> Blocks;
+            static std::mutex Threadguard;
+
+            std::lock_guard<std::mutex> Lock(Threadguard);
+            Size = (Size + 15) & ~size_t(15);
+
+            for (auto &Block : Blocks)
+            {
+                if (size_t(Block.End - Block.Current) < Size) continue;
+                if (Near && !(Isnear(Near, size_t(Block.Current)) && Isnear(Near, size_t(Block.End)))) continue;
+
+                auto Result = Block.Current;
+                Block.Current += Size;
+                return Result;
+            }
+
+            auto Block = Near ? Allocatenearblock(Near) : Allocateblock(0);
+            if (!Block) return nullptr;
+
+            Blocks.push_back({ Block + Size, Block + Blocksize });
+            return Block;
+        }
+
+        // jmp [rip + 2], the address is aligned so retargeting is a single store.
+        void Writerelay(uint8_t *Relay, size_t Target)
+        {
+            const uint8_t Header[] = { 0xFF, 0x25, 0x02, 0x00, 0x00, 0x00, 0xCC, 0xCC };
+            std::memcpy(Relay, Header, sizeof(Header));
+            *reinterpret_cast<volatile uint64_t *>(Relay + sizeof(Header)) = uint64_t(Target);
+        }
+
+        // A 5 byte jump or call, through the relay when the target is out of reach.
+        bool Writerelative(uint8_t Opcode, void *Location, void *Target, void *Relay)
+        {
+            size_t Destination = size_t(Target);
+            if (!Isnear(size_t(Location) + 5, Destination))
+            {
+                if (!Relay || !Isnear(size_t(Location) + 5, size_t(Relay))) return false;
+
+                Writerelay((uint8_t *)Relay, Destination);
+                Destination = size_t(Relay);
+            }
+
+            auto Displacement = uint32_t(Destination - (size_t(Location) + 5));
+            *(uint8_t *)Location = Opcode;
+            std::memcpy((uint8_t *)Location + 1, &Displacement, sizeof(uint32_t));
+            return true;
+        }
+
+        // Builds position dependent code, Far assumes the worst case while sizing.
+        using Offsets_t = std::vector<std::pair<uint8_t, uint8_t>>;
+        struct Emitter_t
+        {
+            std::vector<uint8_t> Code;
+            size_t Base;
+            bool Far;
+            Offsets_t Offsets;
+
+            size_t Here() const { return Base + Code.size(); }
+            bool Reaches(size_t Target, size_t Instructionsize) const
+            {
+            #if defined(ENVIRONMENT64)
+                if (Far) return false;
+            #endif
+                return Isnear(Here() + Instructionsize, Target);
+            }
+            void Bytes(std::initializer_list<uint8_t> Data) { Code.insert(Code.end(), Data); }
+            void Word(const void *Data, size_t Size) { Code.insert(Code.end(), (const uint8_t *)Data, (const uint8_t *)Data + Size); }
+            void Relative(size_t Target)
+            {
+                auto Displacement = uint32_t(Target - (Here() + sizeof(uint32_t)));
+                Word(&Displacement, sizeof(uint32_t));
+            }
+            void Absolute(size_t Target)
+            {
+                auto Address = uint64_t(Target);
+                Word(&Address, sizeof(uint64_t));
+            }
+
+            void Jump(size_t Target)
+            {
+                if (Reaches(Target, 5)) { Bytes({ 0xE9 }); Relative(Target); }
+                else { Bytes({ 0xFF, 0x25, 0x00, 0x00, 0x00, 0x00 }); Absolute(Target); }
+            }
+            void Call(size_t Target)
+            {
+                if (Reaches(Target, 5)) { Bytes({ 0xE8 }); Relative(Target); }
+                else { Bytes({ 0xFF, 0x15, 0x02, 0x00, 0x00, 0x00, 0xEB, 0x08 }); Absolute(Target); }
+            }
+            void Conditional(uint8_t Condition, size_t Target)
+            {
+                if (Reaches(Target, 6)) { Bytes({ 0x0F, uint8_t(0x80 | Condition) }); Relative(Target); }
+                else { Bytes({ uint8_t(0x70 | (Condition ^ 1)), 0x0E }); Jump(Target); }
+            }
+        };
+
+        // Copy the instructions, rewriting their relative operands, and jump back.
+        using Decoded_t = std::vector<std::pair<const uint8_t *, Disassembler::Instruction_t>>;
+        bool Emit(Emitter_t &Output, const Decoded_t &Instructions, size_t Resume)
+        {
+            for (auto &Item : Instructions)
+            {
+                const auto &Instruction = Item.second;
+                Output.Offsets.push_back({ uint8_t(Item.first - Instructions.front().first), uint8_t(Output.Code.size()) });
+
+                switch (Instruction.Kind)
+                {
+                    case Disassembler::REL_JUMP: Output.Jump(Instruction.Target); break;
+                    case Disassembler::REL_CALL: Output.Call(Instruction.Target); break;
+                    case Disassembler::REL_CONDITIONAL: Output.Conditional(Instruction.Condition, Instruction.Target); break;
+
+                    case Disassembler::REL_MEMORY:
+                    {
+                        size_t Start = Output.Code.size();
+                        if (!Output.Far && !Isnear(Output.Here() + Instruction.Length, Instruction.Target)) return false;
+
+                        auto Displacement = uint32_t(Instruction.Target - (Output.Here() + Instruction.Length));
+                        Output.Word(Item.first, Instruction.Length);
+                        std::memcpy(Output.Code.data() + Start + Instruction.Displacementoffset, &Displacement, sizeof(uint32_t));
+                        break;
+                    }
+
+                    default: Output.Word(Item.first, Instruction.Length); break;
+                }
+            }
+
+            Output.Jump(Resume);
+            return true;
+        }
+
+        // Relocate the whole instructions covering Minimum bytes, nullptr if they can not be moved.
+        void *Relocate(const uint8_t *Location, size_t Minimum, size_t Near, Offsets_t &Offsets, void *&Relay)
+        {
+            Decoded_t Instructions;
+            size_t Stolen = 0;
+
+            while (Stolen < Minimum)
+            {
+                Disassembler::Instruction_t Instruction;
+                if (!Disassembler::Decode(Location + Stolen, Instruction)) return nullptr;
+                if (Instruction.Kind == Disassembler::REL_LOOP) return nullptr;
+
+                Instructions.push_back({ Location + Stolen, Instruction });
+                Stolen += Instruction.Length;
+
+                // The function is shorter than the patch.
+                if (Instruction.Terminator && Stolen < Minimum) return nullptr;
+            }
+
+            // Branches into the moved instructions can not be followed.
+            for (auto &Item : Instructions)
+            {
+                const auto &Instruction = Item.second;
+                if (Instruction.Kind == Disassembler::REL_NONE || Instruction.Kind == Disassembler::REL_MEMORY) continue;
+                if (Instruction.Target >= size_t(Location) && Instruction.Target < size_t(Location) + Stolen) return nullptr;
+            }
+
+            Emitter_t Sizing{ {}, 0, true, {} };
+            Emit(Sizing, Instructions, size_t(Location) + Stolen);
+
+            // A near block starts with the relay for the 5 byte patch.
+            const size_t Header = Near ? Relaysize : 0;
+            auto Block = Allocatetrampoline(Header + Sizing.Code.size(), Near);
+            if (!Block) return nullptr;
+            auto Trampoline = Block + Header;
+
+            Emitter_t Output{ {}, size_t(Trampoline), false, {} };
+            if (!Emit(Output, Instructions, size_t(Location) + Stolen)) return nullptr;
+
+            std::memcpy(Trampoline, Output.Code.data(), Output.Code.size());
+            Offsets = std::move(Output.Offsets);
+            Relay = Header ? Block : nullptr;
+            return Trampoline;
+        }
+        void *Createtrampoline(const uint8_t *Location, Offsets_t &Offsets, void *&Relay)
+        {
+            // Without free memory within reach more of the function is overwritten.
+            if (auto Trampoline = Relocate(Location, 5, size_t(Location), Offsets, Relay)) return Trampoline;
+            return Relocate(Location, Farjumpsize, 0, Offsets, Relay);
+        }
+
+        // An absolute jump that leaves all registers intact.
+        size_t Writejump(void *Location, void *Target)
+        {
+            Emitter_t Output{ {}, size_t(Location), true, {} };
+            Output.Jump(size_t(Target));
+
+            std::memcpy(Location, Output.Code.data(), Output.Code.size());
+            return Output.Code.size();
+        }
     }
-    Memprotect::Protectrange(Savedlocation, 20, Protection);
+}
 
-    return true;
+// Make the memory writable around the hooks own write.
+bool Hooking::IHook::Installhook(void *Location, void *Target)
+{
+    if (!Preparehook(Location)) return false;
+
+    const auto Protections = Memprotect::Unprotectrange(Location, sizeof(Savedcode));
+    bool Result = Writehook(Location, Target);
+    Memprotect::Protectrange(Location, sizeof(Savedcode), Protections);
+
+    return Result;
 }
-bool Hooking::Callhook::Removehook()
+bool Hooking::IHook::Removehook()
 {
-    auto Protection = Memprotect::Unprotectrange(Savedlocation, 20);
-    {
-        std::memcpy(Savedlocation, Savedcode, 20);
-    }
-    Memprotect::Protectrange(Savedlocation, 20, Protection);
+    const auto Protections = Memprotect::Unprotectrange(Savedlocation, sizeof(Savedcode));
+    bool Result = Restorehook();
+    Memprotect::Protectrange(Savedlocation, sizeof(Savedcode), Protections);
 
+    return Result;
+}
+
+// Callable originals for the extended hooks.
+void *Hooking::Stomphook::Resolveoriginal(void *Location, Internal::Offsets_t &Offsets, void *&Relay)
+{
+    // A near trampoline's block starts with a relay, so the patch needs no other block.
+    auto Trampoline = Internal::Createtrampoline((const uint8_t *)Location, Offsets, Relay);
+    return Trampoline ? Trampoline : Location;
+}
+void *Hooking::Callhook::Resolveoriginal(void *Location, Internal::Offsets_t &, void *&)
+{
+    Disassembler::Instruction_t Instruction;
+    if (Disassembler::Decode(Location, Instruction) && Instruction.Kind == Disassembler::REL_CALL)
+        return (void *)Instruction.Target;
+
+    return Location;
+}
+
+// Restore the memory where the hook was placed.
+bool Hooking::Stomphook::Restorehook()
+{
+    std::memcpy(Savedlocation, Savedcode, 20);
+    return true;
+}
+bool Hooking::Callhook::Restorehook()
+{
+    std::memcpy(Savedlocation, Savedcode, 20);
     return true;
 }
 
 // Overwrite the games code with a redirection.
 #if defined (ENVIRONMENT64)
-bool Hooking::Stomphook::Installhook(void *Location, void *Target)
+
+// A relay within reach of the hook allows for a 5 byte patch.
+bool Hooking::Stomphook::Preparehook(void *Location)
+{
+    if (!Relay || !Internal::Isnear(size_t(Location) + 5, size_t(Relay)))
+        Relay = Internal::Allocatetrampoline(Internal::Relaysize, size_t(Location));
+    return true;
+}
+bool Hooking::Callhook::Preparehook(void *Location)
+{
+    if (!Relay || !Internal::Isnear(size_t(Location) + 5, size_t(Relay)))
+        Relay = Internal::Allocatetrampoline(Internal::Relaysize, size_t(Location));
+    return true;
+}
+
+bool Hooking::Stomphook::Writehook(void *Location, void *Target)
 {
     Savedlocation = Location;
     Savedtarget = Target;
 
-    auto Protection = Memprotect::Unprotectrange(Savedlocation, 20);
-    {
-        std::memcpy(Savedcode, Savedlocation, 20);
+    std::memcpy(Savedcode, Savedlocation, 20);
+    if (Internal::Writerelative(0xE9, Location, Target, Relay)) return true;
 
+    // Clobbers RAX.
+    {
         *(uint8_t *)(uint64_t(Savedlocation) + 0) = 0x48;
         *(uint8_t *)(uint64_t(Savedlocation) + 1) = 0xB8;
         *(uint64_t *)(uint64_t(Savedlocation) + 2) = uint64_t(Target);
         *(uint8_t *)(uint64_t(Savedlocation) + 10) = 0xFF;
         *(uint8_t *)(uint64_t(Savedlocation) + 11) = 0xE0;
     }
-    Memprotect::Protectrange(Savedlocation, 20, Protection);
 
     return true;
 }
-bool Hooking::Callhook::Installhook(void *Location, void *Target)
+bool Hooking::Callhook::Writehook(void *Location, void *Target)
 {
     Savedlocation = Location;
     Savedtarget = Target;
 
-    auto Protection = Memprotect::Unprotectrange(Savedlocation, 20);
-    {
-        std::memcpy(Savedcode, Savedlocation, 20);
+    std::memcpy(Savedcode, Savedlocation, 20);
+    if (Internal::Writerelative(0xE8, Location, Target, Relay)) return true;
 
+    // Clobbers RAX.
+    {
         *(uint8_t *)(uint64_t(Savedlocation) + 0) = 0x48;
         *(uint8_t *)(uint64_t(Savedlocation) + 1) = 0xB8;
         *(uint64_t *)(uint64_t(Savedlocation) + 2) = uint64_t(Target);
         *(uint8_t *)(uint64_t(Savedlocation) + 10) = 0xFF;
         *(uint8_t *)(uint64_t(Savedlocation) + 11) = 0xD0;
     }
-    Memprotect::Protectrange(Savedlocation, 20, Protection);
 
     return true;
 }
 
 #else
 
-bool Hooking::Stomphook::Installhook(void *Location, void *Target)
+bool Hooking::Stomphook::Preparehook(void *) { return true; }
+bool Hooking::Callhook::Preparehook(void *) { return true; }
+
+bool Hooking::Stomphook::Writehook(void *Location, void *Target)
 {
     Savedlocation = Location;
     Savedtarget = Target;
 
-    auto Protection = Memprotect::Unprotectrange(Savedlocation, 20);
+    std::memcpy(Savedcode, Savedlocation, 20);
     {
-        std::memcpy(Savedcode, Savedlocation, 20);
-
         *(uint8_t *)(uint32_t(Savedlocation) + 0) = 0xE9;
         *(uint32_t *)(uint32_t(Savedlocation) + 1) = uint32_t(Target) - uint32_t(Location) - 5;
     }
-    Memprotect::Protectrange(Savedlocation, 20, Protection);
 
     return true;
 }
-bool Hooking::Callhook::Installhook(void *Location, void *Target)
+bool Hooking::Callhook::Writehook(void *Location, void *Target)
 {
     Savedlocation = Location;
     Savedtarget = Target;
 
-    auto Protection = Memprotect::Unprotectrange(Savedlocation, 20);
+    std::memcpy(Savedcode, Savedlocation, 20);
     {
-        std::memcpy(Savedcode, Savedlocation, 20);
-
         *(uint8_t *)(uint32_t(Savedlocation) + 0) = 0xE8;
         *(uint32_t *)(uint32_t(Savedlocation) + 1) = uint32_t(Target) - uint32_t(Location) - 5;
     }
-    Memprotect::Protectrange(Savedlocation, 20, Protection);
 
     return true;
 }
 #endif
+
+// Relocating may allocate, so it is done before the write.
+bool Hooking::Trampolinehook::Preparehook(void *Location)
+{
+    // Reinstalls reuse the trampoline.
+    if (Original && Location == Savedlocation) return true;
+
+    Original = Internal::Createtrampoline((const uint8_t *)Location, Offsets, Relay);
+    if (!Original) return false;
+
+    Savedlocation = Location;
+    return true;
+}
+
+// Redirect to the target, the overwritten instructions run from the trampoline.
+bool Hooking::Trampolinehook::Writehook(void *Location, void *Target)
+{
+    if (!Preparehook(Location)) return false;
+
+    Savedlocation = Location;
+    Savedtarget = Target;
+
+    std::memcpy(Savedcode, Savedlocation, 20);
+    if (Internal::Writerelative(0xE9, Savedlocation, Savedtarget, Relay)) Patchsize = 5;
+    else Patchsize = Internal::Writejump(Savedlocation, Savedtarget);
+
+    return true;
+}
+bool Hooking::Trampolinehook::Restorehook()
+{
+    std::memcpy(Savedlocation, Savedcode, Patchsize);
+    return true;
+}
+
+// Threads inside the moved instructions continue in the trampoline.
+size_t Hooking::Trampolinehook::Relocatethread(size_t Address)
+{
+    // The first instruction is where the jump lands anyway.
+    for (const auto &Offset : Offsets)
+    {
+        if (Offset.first && Address == size_t(Savedlocation) + Offset.first)
+            return size_t(Original) + Offset.second;
+    }
+
+    return Address;
+}
+
+// Other threads are parked while the code is written.
+namespace Hooking
+{
+    namespace Internal
+    {
+        #if defined(_WIN32)
+
+        using Suspended_t = std::vector<HANDLE>;
+        void Suspendthreads(Suspended_t &Threads)
+        {
+            auto Snapshot = CreateToolhelp32Snapshot(TH32CS_SNAPTHREAD, 0);
+            if (Snapshot == INVALID_HANDLE_VALUE) return;
+
+            // A suspended thread may hold the heap lock, so nothing allocates after the first suspension.
+            std::vector<DWORD> Threadids;
+            THREADENTRY32 Entry{ sizeof(THREADENTRY32) };
+            if (Thread32First(Snapshot, &Entry))
+            {
+                do
+                {
+                    if (Entry.th32OwnerProcessID != GetCurrentProcessId() || Entry.th32ThreadID == GetCurrentThreadId()) continue;
+                    Threadids.push_back(Entry.th32ThreadID);
+
+                } while (Thread32Next(Snapshot, &Entry));
+            }
+
+            CloseHandle(Snapshot);
+            Threads.reserve(Threads.size() + Threadids.size());
+
+            for (const auto &Threadid : Threadids)
+            {
+                auto Handle = OpenThread(THREAD_SUSPEND_RESUME | THREAD_GET_CONTEXT | THREAD_SET_CONTEXT, FALSE, Threadid);
+                if (!Handle) continue;
+
+                if (SuspendThread(Handle) != DWORD(-1)) Threads.push_back(Handle);
+                else CloseHandle(Handle);
+            }
+        }
+        void Resumethreads(Suspended_t &Threads)
+        {
+            for (auto &Handle : Threads)
+            {
+                ResumeThread(Handle);
+                CloseHandle(Handle);
+            }
+            Threads.clear();
+        }
+
+        // Suspension is asynchronous until the context is read.
+        template <typename Callback> void Movethreads(Suspended_t &Threads, Callback &&Relocate)
+        {
+            for (auto &Handle : Threads)
+            {
+                CONTEXT Context{};
+                Context.ContextFlags = CONTEXT_CONTROL;
+                if (!GetThreadContext(Handle, &Context)) continue;
+
+            #if defined(ENVIRONMENT64)
+                auto &Address = Context.Rip;
+            #else
+                auto &Address = Context.Eip;
+            #endif
+
+                auto Moved = Relocate(size_t(Address));
+                if (Moved == size_t(Address)) continue;
+
+                Address = decltype(Address)(Moved);
+                SetThreadContext(Handle, &Context);
+            }
+        }
+
+        #else
+
+        // Signalled threads spin in the handler until released, their context is restored on return.
+        constexpr size_t Maxparked = 1024;
+        std::atomic<ucontext_t *> Parkedcontexts[Maxparked]{};
+        std::atomic<size_t> Parkedthreads{}, Arrivedthreads{};
+        std::atomic<bool> Holdthreads{};
+        struct sigaction Previousaction{};
+        void Parkthread(int Signal, siginfo_t *Info, void *Context)
+        {
+            // The handler stays installed, late deliveries go to whoever had the signal before.
+            if (!Holdthreads)
+            {
+                if (Previousaction.sa_flags & SA_SIGINFO) { if (Previousaction.sa_sigaction) Previousaction.sa_sigaction(Signal, Info, Context); }
+                else if (Previousaction.sa_handler != SIG_DFL && Previousaction.sa_handler != SIG_IGN) Previousaction.sa_handler(Signal);
+                return;
+            }
+
+            auto Slot = Parkedthreads++;
+            if (Slot < Maxparked) Parkedcontexts[Slot] = (ucontext_t *)Context;
+            Arrivedthreads++;
+
+            while (Holdthreads) sched_yield();
+            Arrivedthreads--;
+        }
+
+        // Threads blocking the signal would never arrive, so they are left running.
+        bool Blockssignal(pid_t Thread, int Signal)
+        {
+            char Path[64], Line[256];
+            std::snprintf(Path, sizeof(Path), "/proc/self/task/%d/status", int(Thread));
+
+            std::FILE *Filehandle = std::fopen(Path, "r");
+            if (!Filehandle) return true;
+
+            bool Blocked = false;
+            while (std::fgets(Line, sizeof(Line), Filehandle))
+            {
+                unsigned long long Mask;
+                if (std::sscanf(Line, "SigBlk: %llx", &Mask) != 1) continue;
+
+                Blocked = (Mask >> (Signal - 1)) & 1;
+                break;
+            }
+
+            std::fclose(Filehandle);
+            return Blocked;
+        }
+
+        // The caller holds Commitguard.
+        struct Suspended_t { bool Active; };
+        void Suspendthreads(Suspended_t &Threads)
+        {
+            static bool Installed = false;
+            const int Signal = SIGRTMIN + 7;
+            size_t Signalled = 0;
+
+            if (!Installed)
+            {
+                struct sigaction Action{};
+                Action.sa_sigaction = Parkthread;
+                Action.sa_flags = SA_RESTART | SA_SIGINFO;
+                sigfillset(&Action.sa_mask);
+                Installed = 0 == sigaction(Signal, &Action, &Previousaction);
+                if (!Installed) return;
+            }
+
+            // Read before any thread is parked, it may hold the allocator.
+            std::vector<pid_t> Targets;
+            auto Directory = opendir("/proc/self/task");
+            if (!Directory) return;
+
+            const auto Self = pid_t(syscall(SYS_gettid));
+            while (auto Item = readdir(Directory))
+            {
+                auto Thread = pid_t(std::strtol(Item->d_name, nullptr, 10));
+                if (Thread <= 0 || Thread == Self || Blockssignal(Thread, Signal)) continue;
+                Targets.push_back(Thread);
+            }
+            closedir(Directory);
+
+            for (auto &Context : Parkedcontexts) Context = nullptr;
+            Parkedthreads = 0;
+            Holdthreads = true;
+            Threads.Active = true;
+
+            for (const auto &Thread : Targets)
+                if (0 == syscall(SYS_tgkill, getpid(), Thread, Signal)) ++Signalled;
+
+            // Threads that exit meanwhile never arrive.
+            const auto Deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(100);
+            while (Arrivedthreads < Signalled && std::chrono::steady_clock::now() < Deadline) sched_yield();
+        }
+        void Resumethreads(Suspended_t &Threads)
+        {
+            if (!Threads.Active) return;
+            Holdthreads = false;
+
+            // The contexts are only valid while the threads are in the handler.
+            const auto Deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(100);
+            while (Arrivedthreads && std::chrono::steady_clock::now() < Deadline) sched_yield();
+
+            for (auto &Context : Parkedcontexts) Context = nullptr;
+            Threads.Active = false;
+        }
+
+        template <typename Callback> void Movethreads(Suspended_t &, Callback &&Relocate)
+        {
+        #if defined(__x86_64__) || defined(__i386__)
+            for (size_t i = 0; i < std::min(Parkedthreads.load(), Maxparked); ++i)
+            {
+                auto Context = Parkedcontexts[i].load();
+                if (!Context) continue;
+
+            #if defined(__x86_64__)
+                auto &Address = Context->uc_mcontext.gregs[REG_RIP];
+            #else
+                auto &Address = Context->uc_mcontext.gregs[REG_EIP];
+            #endif
+
+                Address = greg_t(Relocate(size_t(Address)));
+            }
+        #else
+            (void)Relocate;
+        #endif
+        }
+
+        #endif
+    }
+}
+
+// Queue the hooks, nothing is written until the commit.
+void Hooking::Transaction_t::Installhook(IHook &Hook, void *Location, void *Target)
+{
+    Entries.push_back({ &Hook, Location, Target, true });
+}
+void Hooking::Transaction_t::Removehook(IHook &Hook)
+{
+    Entries.push_back({ &Hook, Hook.Savedlocation, Hook.Savedtarget, false });
+}
+
+// Every page is made writable once, the protection is restored in runs.
+size_t Hooking::Transaction_t::Commit()
+{
+    // Concurrent commits would suspend each other.
+    static std::mutex Commitguard;
+    std::lock_guard<std::mutex> Lock(Commitguard);
+
+    const size_t Pagesize = Memprotect::Pagesize();
+    std::vector<bool> Prepared(Entries.size());
+    std::vector<size_t> Pages;
+    Pages.reserve(Entries.size() * 2);
+
+    for (size_t i = 0; i < Entries.size(); ++i)
+    {
+        auto &Entry = Entries[i];
+        if (!Entry.Location) continue;
+
+        // Allocations are not safe while other threads are parked.
+        if (Entry.Install && !Entry.Hook->Preparehook(Entry.Location)) continue;
+        Prepared[i] = true;
+
+        const auto Address = size_t(Entry.Location);
+        for (size_t Page = Address & ~(Pagesize - 1); Page < Address + sizeof(IHook::Savedcode); Page += Pagesize)
+            Pages.push_back(Page);
+    }
+
+    std::sort(Pages.begin(), Pages.end());
+    Pages.erase(std::unique(Pages.begin(), Pages.end()), Pages.end());
+    const auto Protections = Memprotect::Pageprotections(Pages);
+
+    // Calls the callback for each run of adjacent pages.
+    const auto Forruns = [&](bool Sameprotection, auto &&Callback)
+    {
+        for (size_t First = 0, Last = 0; First < Pages.size(); First = Last)
+        {
+            for (Last = First + 1; Last < Pages.size(); ++Last)
+            {
+                if (Pages[Last] != Pages[Last - 1] + Pagesize) break;
+                if (Sameprotection && Protections[Last] != Protections[First]) break;
+            }
+
+            Callback((void *)Pages[First], (Last - First) * Pagesize, Protections[First]);
+        }
+    };
+
+    Internal::Suspended_t Suspended{};
+    if (Suspendthreads) Internal::Suspendthreads(Suspended);
+
+    Forruns(false, [](void *Address, size_t Length, unsigned long)
+    {
+        Memprotect::Setprotection(Address, Length, Memprotect::Fullaccess);
+    });
+
+    size_t Count = 0;
+    for (size_t i = 0; i < Entries.size(); ++i)
+    {
+        if (!Prepared[i]) continue;
+
+        auto &Entry = Entries[i];
+        if (Entry.Install) Count += Entry.Hook->Writehook(Entry.Location, Entry.Target);
+        else Count += Entry.Hook->Restorehook();
+    }
+
+    // Threads stopped inside the replaced instructions would resume in the middle of the jump.
+    if (Suspendthreads)
+    {
+        Internal::Movethreads(Suspended, [&](size_t Address)
+        {
+            for (size_t i = 0; i < Entries.size(); ++i)
+                if (Prepared[i] && Entries[i].Install) Address = Entries[i].Hook->Relocatethread(Address);
+            return Address;
+        });
+    }
+
+    Forruns(true, [](void *Address, size_t Length, unsigned long Protection)
+    {
+        Memprotect::Setprotection(Address, Length, Protection);
+    });
+
+    if (Suspendthreads) Internal::Resumethreads(Suspended);
+
+    Entries.clear();
+    return Count;
+}
@@ -12,43 +12,130 @@
 
 namespace Hooking
 {
-    #define EXTENDEDHOOKDECL(Basehook)                                  \
-    template <typename Signature>                                       \
-    struct Basehook ##Ex : public Basehook                              \
-    {                                                                   \
-        std::pair<std::mutex, std::function<Signature>> Function;       \
-        virtual bool Installhook(void *Location, void *Target) override \
-        {                                                               \
-            Function.second = *(Signature *)Location;                   \
-            return Basehook::Installhook(Location, Target);             \
-        }                                                               \
-    }                                                                   \
+    // The original code as a typed pointer, calling it is a plain indirect call.
+    template <typename Signature>
+    struct Original_t
+    {
+        std::atomic<Signature *> Pointer{};
+
+        template <typename ... Arguments>
+        decltype(auto) operator()(Arguments &&... Args) const
+        {
+            return Pointer.load(std::memory_order_acquire)(std::forward<Arguments>(Args)...);
+        }
+    };
+
+    #define EXTENDEDHOOKDECL(Basehook)                                                  \
+    template <typename Signature>                                                       \
+    struct Basehook ##Ex : public Basehook                                              \
+    {                                                                                   \
+        Original_t<Signature> Function;                                                 \
+        std::vector<std::pair<uint8_t, uint8_t>> Offsets;                               \
+        virtual bool Preparehook(void *Location) override                               \
+        {                                                                               \
+            if (!Function.Pointer || Location != Savedlocation)                         \
+                Function.Pointer = (Signature *)Basehook::Resolveoriginal(Location, Offsets, Relay); \
+            return Basehook::Preparehook(Location);                                     \
+        }                                                                               \
+        virtual size_t Relocatethread(size_t Address) override                          \
+        {                                                                               \
+            for (const auto &Offset : Offsets)                                          \
+                if (Offset.first && Address == size_t(Savedlocation) + Offset.first)    \
+                    return size_t(Function.Pointer.load()) + Offset.second;             \
+            return Address;                                                             \
+        }                                                                               \
+    }                                                                                   \
 
     // Basic interface for hooks.
     struct IHook
     {
         uint8_t Savedcode[20]{};
-        void *Savedlocation;
-        void *Savedtarget;
+        void *Savedlocation{};
+        void *Savedtarget{};
+
+        // Jumps to the target from within reach of the hook, x64 only.
+        void *Relay{};
+
+        // Only writes the code, the caller makes the memory writable.
+        virtual bool Writehook(void *Location, void *Target) = 0;
+        virtual bool Restorehook() = 0;
 
-        virtual bool Removehook() = 0;
-        virtual bool Installhook(void *Location, void *Target) = 0;
+        // Work that may allocate, done before other threads are suspended.
+        virtual bool Preparehook(void *) { return true; }
+
+        // Where a suspended thread inside the overwritten code continues.
+        virtual size_t Relocatethread(size_t Address) { return Address; }
+
+        virtual bool Removehook();
+        virtual bool Installhook(void *Location, void *Target);
         virtual bool Reinstall() { return Installhook(Savedlocation, Savedtarget); };
     };
 
     // A dumb hook that just inserts a jump.
     struct Stomphook : public IHook
     {
-        virtual bool Removehook() override;
-        virtual bool Installhook(void *Location, void *Target) override;
+        // A relocated copy of the overwritten code, the location itself if it can not be moved.
+        // Offsets map the moved instructions and Relay is the near block's relay for the patch.
+        static void *Resolveoriginal(void *Location, std::vector<std::pair<uint8_t, uint8_t>> &Offsets, void *&Relay);
+
+        virtual bool Restorehook() override;
+        virtual bool Preparehook(void *Location) override;
+        virtual bool Writehook(void *Location, void *Target) override;
     };
     EXTENDEDHOOKDECL(Stomphook);
 
     // A dumb hook that just inserts a call.
     struct Callhook : public IHook
     {
-        virtual bool Removehook() override;
-        virtual bool Installhook(void *Location, void *Target) override;
+        // The function called from the location, the location itself if it is not a call.
+        static void *Resolveoriginal(void *Location, std::vector<std::pair<uint8_t, uint8_t>> &Offsets, void *&Relay);
+
+        virtual bool Restorehook() override;
+        virtual bool Preparehook(void *Location) override;
+        virtual bool Writehook(void *Location, void *Target) override;
     };
     EXTENDEDHOOKDECL(Callhook);
+
+    // Moves the overwritten instructions to a trampoline, the original stays callable through it.
+    struct Trampolinehook : public IHook
+    {
+        void *Original{};
+        size_t Patchsize{};
+
+        // Offset of each moved instruction in the function and in the trampoline.
+        std::vector<std::pair<uint8_t, uint8_t>> Offsets;
+
+        virtual bool Restorehook() override;
+        virtual bool Preparehook(void *Location) override;
+        virtual size_t Relocatethread(size_t Address) override;
+        virtual bool Writehook(void *Location, void *Target) override;
+    };
+    template <typename Signature>
+    struct TrampolinehookEx : public Trampolinehook
+    {
+        Original_t<Signature> Function;
+        virtual bool Preparehook(void *Location) override
+        {
+            if (!Trampolinehook::Preparehook(Location)) return false;
+            Function.Pointer = (Signature *)Original;
+            return true;
+        }
+    };
+
+    // Collects hooks and writes them with a single protection change per page.
+    struct Transaction_t
+    {
+        // Park the other threads while the code is written, on Nix threads blocking SIGRTMIN+7 keep running.
+        bool Suspendthreads{};
+
+        void Installhook(IHook &Hook, void *Location, void *Target);
+        void Removehook(IHook &Hook);
+
+        // Writes the queued hooks, returns how many succeeded.
+        size_t Commit();
+
+    private:
+        struct Entry_t { IHook *Hook; void *Location, *Target; bool Install; };
+        std::vector<Entry_t> Entries;
+    };
 }
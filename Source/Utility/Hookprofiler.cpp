@@ -0,0 +1,178 @@
+/*
+    Initial author: Convery (tcn@hedgehogscience.com)
+    Started: 19-10-2026
+    License: MIT
+    Notes:
+        Counts calls and cycles spent in hooks marked with
+        Profilehook(), every thread has its own counters so
+        the hot path never shares a cacheline. The macro is
+        compiled out unless HOOKING_PROFILE is set.
+*/
+
+#include "../Stdinclude.hpp"
+#include <condition_variable>
+
+namespace Hooking
+{
+    namespace Profiler
+    {
+        namespace Internal
+        {
+            static std::mutex Threadguard;
+            static std::vector<std::string> Sitenames;
+            static std::vector<Counters_t *> Threadcounters;
+            static uint64_t Retiredcalls[HOOKING_PROFILE_SITES]{}, Retiredcycles[HOOKING_PROFILE_SITES]{};
+
+            // Cycles are converted with the rate measured since the first site was registered.
+            static uint64_t Startcycles;
+            static std::chrono::steady_clock::time_point Starttime;
+            double Cyclespermillisecond()
+            {
+                const auto Milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - Starttime).count();
+                return Milliseconds > 0 ? double(Timestamp() - Startcycles) / Milliseconds : 0;
+            }
+
+            // The totals of exiting threads are kept.
+            struct Retire_t
+            {
+                Counters_t *Counters{};
+                ~Retire_t()
+                {
+                    if (!Counters) return;
+
+                    std::lock_guard<std::mutex> Lock(Threadguard);
+                    for (size_t i = 0; i < HOOKING_PROFILE_SITES; ++i)
+                    {
+                        Retiredcalls[i] += Counters->Calls[i].load(std::memory_order_relaxed);
+                        Retiredcycles[i] += Counters->Cycles[i].load(std::memory_order_relaxed);
+                    }
+
+                    Threadcounters.erase(std::find(Threadcounters.begin(), Threadcounters.end(), Counters));
+                    Localcounters = nullptr;
+                    delete Counters;
+                }
+            };
+            static thread_local Retire_t Retire;
+
+            Counters_t *Attachthread()
+            {
+                auto Counters = new Counters_t();
+                {
+                    std::lock_guard<std::mutex> Lock(Threadguard);
+                    Threadcounters.push_back(Counters);
+                }
+
+                Retire.Counters = Counters;
+                Localcounters = Counters;
+                return Counters;
+            }
+
+            // Wakes up every interval until Shutdown(). Never destroyed, static destructors
+            // run under the loader lock on Windows where joining would deadlock.
+            struct Dumper_t
+            {
+                std::condition_variable Wakeup;
+                std::thread Worker;
+                std::mutex Lock;
+                bool Terminate{};
+
+                void Start()
+                {
+                    std::lock_guard<std::mutex> Guard(Lock);
+                    if (Terminate || Worker.joinable()) return;
+
+                    Worker = std::thread([this]()
+                    {
+                        std::unique_lock<std::mutex> Guard(Lock);
+                        while (!Wakeup.wait_for(Guard, std::chrono::seconds(HOOKING_PROFILE_INTERVAL), [this]() { return Terminate; }))
+                        {
+                            Guard.unlock();
+                            Dump();
+                            Guard.lock();
+                        }
+                    });
+                }
+                void Stop()
+                {
+                    std::thread Finished;
+                    {
+                        std::lock_guard<std::mutex> Guard(Lock);
+                        Terminate = true;
+                        Finished = std::move(Worker);
+                    }
+
+                    Wakeup.notify_all();
+                    if (Finished.joinable()) Finished.join();
+                }
+            };
+            Dumper_t &Dumper()
+            {
+                static auto Instance = new Dumper_t();
+                return *Instance;
+            }
+        }
+
+        // Called once per callsite by the macro.
+        uint32_t Registersite(const char *Name)
+        {
+            std::lock_guard<std::mutex> Lock(Internal::Threadguard);
+
+            if (Internal::Sitenames.empty())
+            {
+                Internal::Startcycles = Internal::Timestamp();
+                Internal::Starttime = std::chrono::steady_clock::now();
+                if (HOOKING_PROFILE_INTERVAL) Internal::Dumper().Start();
+            }
+
+            // The last slot is shared by everything past the limit.
+            if (Internal::Sitenames.size() < HOOKING_PROFILE_SITES - 1)
+            {
+                Internal::Sitenames.emplace_back(Name);
+                return uint32_t(Internal::Sitenames.size() - 1);
+            }
+
+            if (Internal::Sitenames.size() == HOOKING_PROFILE_SITES - 1) Internal::Sitenames.emplace_back("Other");
+            return HOOKING_PROFILE_SITES - 1;
+        }
+
+        // Totals per site over all threads, including the ones that have exited.
+        std::vector<Stats_t> Snapshot()
+        {
+            std::lock_guard<std::mutex> Lock(Internal::Threadguard);
+            const auto Rate = Internal::Cyclespermillisecond();
+            std::vector<Stats_t> Result;
+            Result.reserve(Internal::Sitenames.size());
+
+            for (size_t i = 0; i < Internal::Sitenames.size(); ++i)
+            {
+                uint64_t Calls = Internal::Retiredcalls[i], Cycles = Internal::Retiredcycles[i];
+                for (const auto &Counters : Internal::Threadcounters)
+                {
+                    Calls += Counters->Calls[i].load(std::memory_order_relaxed);
+                    Cycles += Counters->Cycles[i].load(std::memory_order_relaxed);
+                }
+
+                Result.push_back({ Internal::Sitenames[i], Calls, Cycles, Rate > 0 ? Cycles / Rate : 0 });
+            }
+
+            return Result;
+        }
+
+        // Stops the periodic dump, call before the module is unloaded but not from DllMain.
+        void Shutdown()
+        {
+            Internal::Dumper().Stop();
+        }
+
+        // Write the snapshot to the log, also done every HOOKING_PROFILE_INTERVAL seconds.
+        void Dump()
+        {
+            for (const auto &Site : Snapshot())
+            {
+                if (!Site.Calls) continue;
+                Logformatted(va("Hook %s: %llu calls, %.3f ms total, %.1f ns average.", Site.Name.c_str(),
+                    (unsigned long long)Site.Calls, Site.Milliseconds, Site.Milliseconds * 1e6 / double(Site.Calls)), 'I');
+            }
+        }
+    }
+}
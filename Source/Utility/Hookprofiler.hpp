@@ -0,0 +1,84 @@
+/*
+    Initial author: Convery (tcn@hedgehogscience.com)
+    Started: 19-10-2026
+    License: MIT
+    Notes:
+        Counts calls and cycles spent in hooks marked with
+        Profilehook(), every thread has its own counters so
+        the hot path never shares a cacheline. The macro is
+        compiled out unless HOOKING_PROFILE is set.
+*/
+
+#pragma once
+#include "../Stdinclude.hpp"
+
+namespace Hooking
+{
+    namespace Profiler
+    {
+        struct Stats_t
+        {
+            std::string Name;
+            uint64_t Calls;
+            uint64_t Cycles;
+            double Milliseconds;
+        };
+
+        // Totals per site over all threads, including the ones that have exited.
+        std::vector<Stats_t> Snapshot();
+
+        // Write the snapshot to the log, also done every HOOKING_PROFILE_INTERVAL seconds.
+        void Dump();
+
+        // Stops the periodic dump, call before the module is unloaded but not from DllMain.
+        void Shutdown();
+
+        // Called once per callsite by the macro.
+        uint32_t Registersite(const char *Name);
+
+        namespace Internal
+        {
+            // Only written by the owning thread, atomic so snapshots can read them without locked instructions.
+            struct Counters_t
+            {
+                std::atomic<uint64_t> Calls[HOOKING_PROFILE_SITES];
+                std::atomic<uint64_t> Cycles[HOOKING_PROFILE_SITES];
+            };
+            inline thread_local Counters_t *Localcounters{};
+            Counters_t *Attachthread();
+
+            inline uint64_t Timestamp()
+            {
+            #if defined(_MSC_VER)
+                return __rdtsc();
+            #elif defined(__x86_64__) || defined(__i386__)
+                return __builtin_ia32_rdtsc();
+            #else
+                return uint64_t(std::chrono::steady_clock::now().time_since_epoch().count());
+            #endif
+            }
+            inline void Increment(std::atomic<uint64_t> &Counter, uint64_t Value)
+            {
+                Counter.store(Counter.load(std::memory_order_relaxed) + Value, std::memory_order_relaxed);
+            }
+        }
+
+        // Times the rest of the enclosing scope.
+        struct Scope_t
+        {
+            uint32_t Site;
+            uint64_t Start;
+
+            explicit Scope_t(uint32_t Siteid) : Site(Siteid), Start(Internal::Timestamp()) {}
+            ~Scope_t()
+            {
+                const auto Elapsed = Internal::Timestamp() - Start;
+                auto Counters = Internal::Localcounters;
+                if (unlikely(!Counters)) Counters = Internal::Attachthread();
+
+                Internal::Increment(Counters->Calls[Site], 1);
+                Internal::Increment(Counters->Cycles[Site], Elapsed);
+            }
+        };
+    }
+}
@@ -21,7 +21,102 @@ namespace Internal
     static std::mutex Threadguard;
 }
 
-// Output to file, assumes nullterminated strings.
+// Severity of a message, LOG_MINLEVEL uses the same values.
+enum Loglevel_t : int
+{
+    LOG_TRACE = 0,
+    LOG_DEBUG = 1,
+    LOG_INFO = 2,
+    LOG_WARNING = 3,
+    LOG_ERROR = 4,
+    LOG_NONE = 5
+};
+
+// Leveled logging state.
+namespace Internal
+{
+    inline std::atomic<int> Runtimelevel{ LOG_MINLEVEL };
+
+    // Token-bucket per callsite so error-storms do not flood the log.
+    struct Ratelimiter_t
+    {
+        std::chrono::steady_clock::time_point Lastrefill{ std::chrono::steady_clock::now() };
+        double Tokens{ LOG_RATELIMIT_BURST };
+        uint32_t Suppressed{};
+        std::mutex Threadguard;
+
+        // Callsites with unreported drops, reported by Flushsuppressed().
+        static inline std::atomic<uint32_t> Pendingcount{};
+        static inline Ratelimiter_t *Pendinghead{};
+        static inline std::mutex Pendingguard;
+        Ratelimiter_t *Nextpending{};
+        bool Pending{};
+
+        const char *Filename;
+        int Line;
+        char Prefix;
+
+        Ratelimiter_t(char Prefix, const char *Filename, int Line) : Filename(Filename), Line(Line), Prefix(Prefix) {}
+        ~Ratelimiter_t()
+        {
+            std::lock_guard<std::mutex> Lock(Pendingguard);
+            for (Ratelimiter_t **Entry = &Pendinghead; *Entry; Entry = &(*Entry)->Nextpending)
+            {
+                if (*Entry != this) continue;
+                *Entry = Nextpending;
+                Pendingcount--;
+                break;
+            }
+        }
+
+        // Returns true if the message should be printed and how many were dropped before it.
+        bool Allow(uint32_t &Suppressedcount)
+        {
+            bool Enqueue = false;
+            {
+                std::lock_guard<std::mutex> Lock(Threadguard);
+                auto Now = std::chrono::steady_clock::now();
+
+                // Refill based on the time since the last message.
+                Tokens += std::chrono::duration<double>(Now - Lastrefill).count() * LOG_RATELIMIT_PERSECOND;
+                if (Tokens > LOG_RATELIMIT_BURST) Tokens = LOG_RATELIMIT_BURST;
+                Lastrefill = Now;
+
+                if (Tokens >= 1.0)
+                {
+                    Tokens -= 1.0;
+                    Suppressedcount = std::exchange(Suppressed, 0);
+                    return true;
+                }
+
+                ++Suppressed;
+                Enqueue = !std::exchange(Pending, true);
+            }
+
+            // Queue the callsite so the count is reported even if it goes quiet.
+            if (Enqueue)
+            {
+                std::lock_guard<std::mutex> Lock(Pendingguard);
+                Nextpending = std::exchange(Pendinghead, this);
+                Pendingcount++;
+            }
+
+            return false;
+        }
+    };
+}
+
+// Change the runtime threshold, messages below LOG_MINLEVEL stay compiled out.
+inline void Setloglevel(Loglevel_t Level)
+{
+    Internal::Runtimelevel.store(Level, std::memory_order_relaxed);
+}
+inline Loglevel_t Getloglevel()
+{
+    return Loglevel_t(Internal::Runtimelevel.load(std::memory_order_relaxed));
+}
+
+// Output to file.
 inline void Logprint(std::string_view Message)
 {
     // Prevent multiple writes to the file.
@@ -31,7 +126,7 @@ inline void Logprint(std::string_view Message)
         auto Filehandle = std::fopen(Internal::Filepath, "a");
         if (Filehandle)
         {
-            std::fputs(Message.data(), Filehandle);
+            std::fwrite(Message.data(), 1, Message.size(), Filehandle);
             std::fputs("\n", Filehandle);
             std::fclose(Filehandle);
         }
@@ -40,7 +135,7 @@ inline void Logprint(std::string_view Message)
 
     // Duplicate the message to STDERR.
     #if !defined(NDEBUG)
-        std::fputs(Message.data(), stderr);
+        std::fwrite(Message.data(), 1, Message.size(), stderr);
         std::fputs("\n", stderr);
     #endif
 }
@@ -52,11 +147,55 @@ inline void Logprintasync(std::string Message)
 // Formatted output, [Type][Time][Message]
 inline void Logformatted(std::string_view Message, char Prefix)
 {
+    static thread_local std::string Line;
     auto Now = std::time(NULL);
     char Buffer[80]{};
 
+    // Reuse the threads line-buffer rather than allocating.
     std::strftime(Buffer, 80, "%H:%M:%S", std::localtime(&Now));
-    Logprint(va("[%c][%-8s] %*s", Prefix, Buffer, static_cast<int>(Message.size()), Message.data()));
+    Line.clear();
+    vaappend(Line, "[%c][%-8s] ", Prefix, Buffer);
+    Line.append(Message);
+    Logprint(Line);
+}
+
+// Formatted output with a summary of what the ratelimiter dropped.
+inline void Logratelimited(std::string_view Message, char Prefix, uint32_t Suppressed)
+{
+    if (Suppressed) Logformatted(va("Suppressed %u messages from this callsite.", Suppressed), Prefix);
+    Logformatted(Message, Prefix);
+}
+
+// Report callsites that dropped messages and have since gone quiet, called on every leveled message.
+namespace Internal
+{
+    inline void Flushsuppressed()
+    {
+        if (!Ratelimiter_t::Pendingcount.load(std::memory_order_relaxed)) return;
+
+        std::lock_guard<std::mutex> Lock(Ratelimiter_t::Pendingguard);
+        const auto Now = std::chrono::steady_clock::now();
+
+        for (Ratelimiter_t **Entry = &Ratelimiter_t::Pendinghead; *Entry;)
+        {
+            Ratelimiter_t *Limiter = *Entry;
+
+            // Busy callsites report their own count with their next message.
+            std::unique_lock<std::mutex> Limiterlock(Limiter->Threadguard, std::try_to_lock);
+            if (!Limiterlock) { Entry = &Limiter->Nextpending; continue; }
+
+            // Still throttled, so the storm is ongoing.
+            const double Tokens = Limiter->Tokens + std::chrono::duration<double>(Now - Limiter->Lastrefill).count() * LOG_RATELIMIT_PERSECOND;
+            if (Limiter->Suppressed && Tokens < 1.0) { Entry = &Limiter->Nextpending; continue; }
+
+            const uint32_t Count = std::exchange(Limiter->Suppressed, 0);
+            *Entry = std::exchange(Limiter->Nextpending, nullptr);
+            Limiter->Pending = false;
+            Ratelimiter_t::Pendingcount--;
+
+            if (Count) Logformatted(va("Suppressed %u messages from %s:%i.", Count, Limiter->Filename, Limiter->Line), Limiter->Prefix);
+        }
+    }
 }
 
 // Delete the log and create a new one.
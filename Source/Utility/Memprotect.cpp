@@ -0,0 +1,236 @@
+/*
+    Initial author: Convery (tcn@hedgehogscience.com)
+    Started: 19-10-2026
+    License: MIT
+    Notes:
+        Changes the page-permissions for a range.
+        On Nix the mappings are indexed once and looked
+        up by binary search, refresh after mapping code.
+*/
+
+#include "../Stdinclude.hpp"
+
+#if defined(_WIN32)
+
+// The system already keeps the index.
+size_t Memprotect::Pagesize()
+{
+    static const size_t Size = []()
+    {
+        SYSTEM_INFO Info;
+        GetSystemInfo(&Info);
+        return size_t(Info.dwPageSize);
+    }();
+
+    return Size;
+}
+void Memprotect::Refreshmappings() {}
+unsigned long Memprotect::Queryprotection(const void *Address)
+{
+    MEMORY_BASIC_INFORMATION Info;
+    if (!VirtualQuery(Address, &Info, sizeof(Info)) || Info.State != MEM_COMMIT) return Fullaccess;
+    return Info.Protect;
+}
+std::vector<unsigned long> Memprotect::Pageprotections(const std::vector<size_t> &Pages)
+{
+    std::vector<unsigned long> Protections(Pages.size());
+    for (size_t i = 0; i < Pages.size(); ++i) Protections[i] = Queryprotection((void *)Pages[i]);
+    return Protections;
+}
+
+// Windows memory protection.
+void Memprotect::Setprotection(void *Address, const size_t Length, unsigned long Protection)
+{
+    unsigned long Temp;
+    VirtualProtect(Address, Length, Protection, &Temp);
+}
+
+#else
+
+namespace Memprotect
+{
+    namespace Internal
+    {
+        struct Mapping_t { size_t Start, End; unsigned long Protection; };
+        static std::vector<Mapping_t> Mappings;
+        static std::atomic<bool> Stale{ true };
+        static std::mutex Mappingguard;
+
+        // Sorted by address as the kernel lists them, the caller holds the lock.
+        void Readmappings()
+        {
+            Mappings.clear();
+            Stale = false;
+
+            std::FILE *Filehandle = std::fopen("/proc/self/maps", "r");
+            if (!Filehandle) return;
+
+            char Buffer[1024]{}, Permissions[5]{};
+            bool Linestart = true;
+            size_t Start, End;
+
+            while (std::fgets(Buffer, 1024, Filehandle))
+            {
+                // Skip the rest of long paths.
+                bool Parse = Linestart;
+                Linestart = std::strchr(Buffer, '\n') != nullptr;
+                if (!Parse || std::sscanf(Buffer, "%zx-%zx %4s", &Start, &End, Permissions) != 3) continue;
+
+                unsigned long Protection = 0;
+                if (Permissions[0] == 'r') Protection |= PROT_READ;
+                if (Permissions[1] == 'w') Protection |= PROT_WRITE;
+                if (Permissions[2] == 'x') Protection |= PROT_EXEC;
+                Mappings.push_back({ Start, End, Protection });
+            }
+
+            std::fclose(Filehandle);
+
+            // Room for the splits from Assign, which may run while other threads are suspended.
+            Mappings.reserve(Mappings.size() * 2 + 64);
+        }
+
+        // Binary search, nullptr for unmapped addresses.
+        const Mapping_t *Find(size_t Address)
+        {
+            auto Item = std::upper_bound(Mappings.begin(), Mappings.end(), Address, [](size_t Value, const Mapping_t &Mapping)
+            {
+                return Value < Mapping.Start;
+            });
+
+            if (Item == Mappings.begin()) return nullptr;
+            --Item;
+
+            return Address < Item->End ? &*Item : nullptr;
+        }
+
+        // Record a change we made, marks the index stale rather than allocating.
+        void Assign(size_t Start, size_t End, unsigned long Protection)
+        {
+            auto First = std::upper_bound(Mappings.begin(), Mappings.end(), Start, [](size_t Value, const Mapping_t &Mapping)
+            {
+                return Value < Mapping.End;
+            });
+            auto Last = std::lower_bound(First, Mappings.end(), End, [](const Mapping_t &Mapping, size_t Value)
+            {
+                return Mapping.Start < Value;
+            });
+
+            // The mappings partially covered keep their protection.
+            Mapping_t Pieces[3];
+            size_t Count = 0;
+            if (First != Last && First->Start < Start) Pieces[Count++] = { First->Start, Start, First->Protection };
+            Pieces[Count++] = { Start, End, Protection };
+            if (First != Last && (Last - 1)->End > End) Pieces[Count++] = { End, (Last - 1)->End, (Last - 1)->Protection };
+
+            if (Mappings.size() - size_t(Last - First) + Count > Mappings.capacity())
+            {
+                Stale = true;
+                return;
+            }
+
+            auto Index = First - Mappings.begin();
+            Mappings.erase(First, Last);
+            Mappings.insert(Mappings.begin() + Index, Pieces, Pieces + Count);
+        }
+    }
+}
+
+size_t Memprotect::Pagesize()
+{
+    static const size_t Size = size_t(getpagesize());
+    return Size;
+}
+void Memprotect::Refreshmappings()
+{
+    std::lock_guard<std::mutex> Lock(Internal::Mappingguard);
+    Internal::Readmappings();
+}
+
+// Memory mapped since the last read triggers a single refresh.
+unsigned long Memprotect::Queryprotection(const void *Address)
+{
+    std::lock_guard<std::mutex> Lock(Internal::Mappingguard);
+    bool Refreshed = Internal::Stale;
+    if (Refreshed) Internal::Readmappings();
+
+    auto Mapping = Internal::Find(size_t(Address));
+    if (!Mapping && !Refreshed)
+    {
+        Internal::Readmappings();
+        Mapping = Internal::Find(size_t(Address));
+    }
+
+    return Mapping ? Mapping->Protection : Fullaccess;
+}
+std::vector<unsigned long> Memprotect::Pageprotections(const std::vector<size_t> &Pages)
+{
+    std::vector<unsigned long> Protections(Pages.size(), Fullaccess);
+    std::lock_guard<std::mutex> Lock(Internal::Mappingguard);
+    bool Refreshed = Internal::Stale;
+    if (Refreshed) Internal::Readmappings();
+
+    for (size_t i = 0; i < Pages.size(); ++i)
+    {
+        auto Mapping = Internal::Find(Pages[i]);
+        if (!Mapping && !Refreshed)
+        {
+            Internal::Readmappings();
+            Refreshed = true;
+            Mapping = Internal::Find(Pages[i]);
+        }
+
+        if (Mapping) Protections[i] = Mapping->Protection;
+    }
+
+    return Protections;
+}
+
+// Nix memory protection, the range is expanded to whole pages.
+void Memprotect::Setprotection(void *Address, const size_t Length, unsigned long Protection)
+{
+    const size_t Pagesize = Memprotect::Pagesize();
+    const size_t Start = size_t(Address) & ~(Pagesize - 1);
+    const size_t End = (size_t(Address) + std::max(Length, size_t(1)) + Pagesize - 1) & ~(Pagesize - 1);
+    if (0 != mprotect((void *)Start, End - Start, int(Protection))) return;
+
+    // A suspended thread may hold the lock.
+    std::unique_lock<std::mutex> Lock(Internal::Mappingguard, std::try_to_lock);
+    if (!Lock.owns_lock()) Internal::Stale = true;
+    else if (!Internal::Stale) Internal::Assign(Start, End, Protection);
+}
+
+#endif
+
+// Pages in a range can differ, so each one is queried and restored.
+static std::vector<size_t> Rangepages(void *Address, const size_t Length)
+{
+    const size_t Pagesize = Memprotect::Pagesize();
+    const size_t End = size_t(Address) + std::max(Length, size_t(1));
+    std::vector<size_t> Pages;
+
+    for (size_t Page = size_t(Address) & ~(Pagesize - 1); Page < End; Page += Pagesize) Pages.push_back(Page);
+    return Pages;
+}
+std::vector<unsigned long> Memprotect::Unprotectrange(void *Address, const size_t Length)
+{
+    auto Oldprotections = Pageprotections(Rangepages(Address, Length));
+    Setprotection(Address, Length, Fullaccess);
+    return Oldprotections;
+}
+void Memprotect::Protectrange(void *Address, const size_t Length, const std::vector<unsigned long> &Oldprotections)
+{
+    const auto Pages = Rangepages(Address, Length);
+    const size_t Count = std::min(Pages.size(), Oldprotections.size());
+
+    for (size_t First = 0, Last = 0; First < Count; First = Last)
+    {
+        for (Last = First + 1; Last < Count; ++Last)
+            if (Oldprotections[Last] != Oldprotections[First]) break;
+
+        Setprotection((void *)Pages[First], (Last - First) * Pagesize(), Oldprotections[First]);
+    }
+}
+void Memprotect::Protectrange(void *Address, const size_t Length, unsigned long Oldprotection)
+{
+    Setprotection(Address, Length, Oldprotection);
+}
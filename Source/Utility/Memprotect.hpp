@@ -4,6 +4,8 @@
     License: MIT
     Notes:
         Changes the page-permissions for a range.
+        On Nix the mappings are indexed once and looked
+        up by binary search, refresh after mapping code.
 */
 
 #pragma once
@@ -12,65 +14,30 @@
 namespace Memprotect
 {
     #if defined(_WIN32)
-
-    // Windows memory protection,
-    inline void Protectrange(void *Address, const size_t Length, unsigned long Oldprotection)
-    {
-        unsigned long Temp;
-        VirtualProtect(Address, Length, Oldprotection, &Temp);
-    }
-    inline unsigned long Unprotectrange(void *Address, const size_t Length)
-    {
-        unsigned long Oldprotection;
-        VirtualProtect(Address, Length, PAGE_EXECUTE_READWRITE, &Oldprotection);
-        return Oldprotection;
-    }
-
+    constexpr unsigned long Fullaccess = PAGE_EXECUTE_READWRITE;
     #else
+    constexpr unsigned long Fullaccess = PROT_READ | PROT_WRITE | PROT_EXEC;
+    #endif
 
-    // Nix memory protection.
-    inline void Protectrange(void *Address, const size_t Length, unsigned long Oldprotection)
-    {
-        int Pagesize = getpagesize();
-        *(size_t *)&Address -= size_t(Address) % Pagesize;
-        mprotect(Address, Pagesize, Oldprotection);
-    }
-    inline unsigned long Unprotectrange(void *Address, const size_t Length)
-    {
-        unsigned long Oldprotection = (PROT_READ | PROT_WRITE | PROT_EXEC);
-
-        // Get the old protection of the range, we assume it's continuous.
-        std::FILE *Filehandle = std::fopen("/proc/self/maps", "r");
-        if(Filehandle)
-        {
-            char Buffer[1024]{}, Permissions[5]{}, Device[6]{}, Mapname[256]{};
-            unsigned long Start, End, Node, Foo;
-
-            while(std::fgets(Buffer, 1024, Filehandle))
-            {
-                std::sscanf(Buffer, "%lx-%lx %4s %lx %5s %ld %s", &Start, &End, Permissions, &Foo, Device, &Node, Mapname);
+    // Granularity of the protection.
+    size_t Pagesize();
 
-                if(Start <= (unsigned long)Address || End >= (unsigned long)Address)
-                {
-                    Oldprotection = 0;
+    // Re-read the mappings, changes made through this module are tracked.
+    void Refreshmappings();
 
-                    if(Permissions[0] == 'r') Oldprotection |= PROT_READ;
-                    if(Permissions[1] == 'w') Oldprotection |= PROT_WRITE;
-                    if(Permissions[2] == 'x') Oldprotection |= PROT_EXEC;
+    // Protection of the page containing the address, unmapped memory reports Fullaccess.
+    unsigned long Queryprotection(const void *Address);
 
-                    break;
-                }
-            }
+    // Protection of each page, the pages are sorted.
+    std::vector<unsigned long> Pageprotections(const std::vector<size_t> &Pages);
 
-            std::fclose(Filehandle);
-        }
+    // Sets the protection for every page the range touches.
+    void Setprotection(void *Address, const size_t Length, unsigned long Protection);
 
-        // Write the new protection.
-        int Pagesize = getpagesize();
-        *(size_t *)&Address -= size_t(Address) % Pagesize;
-        mprotect(Address, Pagesize, PROT_READ | PROT_WRITE | PROT_EXEC);
-        return Oldprotection;
-    }
+    // Makes the range writable, returns the protection of every page it touches.
+    std::vector<unsigned long> Unprotectrange(void *Address, const size_t Length);
 
-    #endif
+    // Restores the pages from Unprotectrange in runs, or sets a single protection for the range.
+    void Protectrange(void *Address, const size_t Length, const std::vector<unsigned long> &Oldprotections);
+    void Protectrange(void *Address, const size_t Length, unsigned long Oldprotection);
 }
@@ -0,0 +1,227 @@
+/*
+    Initial author: Convery (tcn@hedgehogscience.com)
+    Started: 19-10-2026
+    License: MIT
+    Notes:
+        Caches first-match offsets in the plugins archive.
+        Entries are keyed on the pattern, range and the module
+        owning it. The cache is dropped when the host changes
+        and is only written by Savepatterncache().
+*/
+
+#include "../Stdinclude.hpp"
+
+namespace Pattern
+{
+    namespace Internal
+    {
+        // FNV-1a over raw bytes, Hash::FNV1a_64 stops at the first null.
+        inline uint64_t Hashbytes(const void *Data, size_t Length, uint64_t Hash = 14695981039346656037u)
+        {
+            auto Pointer = reinterpret_cast<const uint8_t *>(Data);
+            for (size_t i = 0; i < Length; ++i) Hash = (Hash ^ Pointer[i]) * 1099511628211u;
+            return Hash;
+        }
+
+        // Path, size and timestamp of a module file, 0 if it is unavailable.
+        uint64_t Fileidentity(const std::string &Path)
+        {
+        #if defined(_WIN32)
+            WIN32_FILE_ATTRIBUTE_DATA Attributes;
+            if (Path.empty() || !GetFileAttributesExA(Path.c_str(), GetFileExInfoStandard, &Attributes)) return 0;
+
+            uint64_t Result = Hashbytes(Path.data(), Path.size());
+            Result = Hashbytes(&Attributes.nFileSizeLow, sizeof(DWORD), Result);
+            Result = Hashbytes(&Attributes.nFileSizeHigh, sizeof(DWORD), Result);
+            return Hashbytes(&Attributes.ftLastWriteTime, sizeof(FILETIME), Result);
+        #else
+            struct stat Attributes;
+            if (Path.empty() || 0 != stat(Path.c_str(), &Attributes)) return 0;
+
+            uint64_t Result = Hashbytes(Path.data(), Path.size());
+            Result = Hashbytes(&Attributes.st_size, sizeof(Attributes.st_size), Result);
+            return Hashbytes(&Attributes.st_mtime, sizeof(Attributes.st_mtime), Result);
+        #endif
+        }
+
+        // Identity of the host module, the text segment if the file is unavailable.
+        uint64_t Modulehash()
+        {
+            static const uint64_t Hash = []()
+            {
+                uint64_t Result = Fileidentity(Findmodule("").Name);
+                if (!Result) Result = Hashbytes((void *)Textsegment.first, Textsegment.second - Textsegment.first);
+                return Result;
+            }();
+
+            return Hash;
+        }
+
+        // Offsets are relative to the range, which is identified by its owning module and its start in it.
+        // Ranges outside of any module only have their size, the cached address is re-checked either way.
+        uint64_t Rangekey(const Range_t &Range, std::unordered_map<std::string, uint64_t> &Identities)
+        {
+            uint64_t Rangesize = Range.second - Range.first, Identity = 0, Modulestart = 0;
+
+            for (const auto &Module : Modules())
+            {
+                const auto Contains = [&](const Range_t &Segment) { return Range.first >= Segment.first && Range.first < Segment.second; };
+                if (Module.Name.empty() || !(Contains(Module.Textsegment) || Contains(Module.Datasegment))) continue;
+
+                auto Entry = Identities.find(Module.Name);
+                if (Entry == Identities.end()) Entry = Identities.emplace(Module.Name, Fileidentity(Module.Name)).first;
+
+                Identity = Entry->second;
+                Modulestart = Range.first - Module.Base;
+                break;
+            }
+
+            uint64_t Key = Hashbytes(&Rangesize, sizeof(Rangesize));
+            Key = Hashbytes(&Identity, sizeof(Identity), Key);
+            return Hashbytes(&Modulestart, sizeof(Modulestart), Key);
+        }
+        uint64_t Entrykey(uint64_t Rangekey, const std::string &Humanreadable)
+        {
+            return Hashbytes(Humanreadable.data(), Humanreadable.size(), Rangekey);
+        }
+
+        // Loaded from the archive on first use, misses are not cached as they can not be re-checked.
+        // Written by Savepatterncache() as archive IO is not safe during static destruction.
+        struct Cache_t
+        {
+            std::unordered_map<std::string, uint64_t> Identities;
+            std::unordered_map<uint64_t, uint64_t> Entries;
+            bool Loaded{}, Dirty{};
+            std::mutex Threadguard;
+
+            void Load()
+            {
+                if (Loaded) return;
+                Loaded = true;
+
+                auto Filebuffer = Package::Read("Patterncache.bin");
+                if (Filebuffer.empty()) return;
+
+                Bytebufferview Reader(Filebuffer);
+                std::vector<uint64_t> Keys, Offsets;
+                if (Reader.Read<uint64_t>() != Modulehash()) return;
+                if (!Reader.Readarray(Keys) || !Reader.Readarray(Offsets) || Keys.size() != Offsets.size()) return;
+
+                Entries.reserve(Keys.size());
+                for (size_t i = 0; i < Keys.size(); ++i) Entries[Keys[i]] = Offsets[i];
+            }
+            void Save()
+            {
+                if (!Dirty) return;
+                Dirty = false;
+
+                std::vector<uint64_t> Keys, Offsets;
+                Keys.reserve(Entries.size());
+                Offsets.reserve(Entries.size());
+                for (auto &Item : Entries)
+                {
+                    Keys.push_back(Item.first);
+                    Offsets.push_back(Item.second);
+                }
+
+                Bytebuffer Writer;
+                Writer.Write(Modulehash());
+                Writer.Writearray(Keys);
+                Writer.Writearray(Offsets);
+
+                std::string Filebuffer((const char *)Writer.Data(), Writer.Size());
+                Package::Write("Patterncache.bin", Filebuffer);
+            }
+        };
+        static Cache_t Cache;
+
+        // The bytes at a cached address must still match.
+        bool Validate(const Range_t &Range, uint64_t Offset, const std::vector<uint8_t> &Pattern, const std::vector<uint8_t> &Mask)
+        {
+            if (Offset > Range.second - Range.first || Range.second - Range.first - Offset < Pattern.size()) return false;
+
+            auto Address = reinterpret_cast<const uint8_t *>(Range.first + Offset);
+            for (size_t i = 0; i < Pattern.size(); ++i)
+                if (Mask[i] && Address[i] != Pattern[i]) return false;
+
+            return true;
+        }
+    }
+
+    // Scans through a cache in the plugins archive, cached addresses are re-checked before use.
+    size_t Findpatterncached(Range_t &Range, const std::string &Humanreadable)
+    {
+        auto Pattern = Stringtopattern(Humanreadable);
+        auto Mask = Stringtomask(Humanreadable);
+        uint64_t Key;
+
+        {
+            std::lock_guard<std::mutex> Lock(Internal::Cache.Threadguard);
+            Key = Internal::Entrykey(Internal::Rangekey(Range, Internal::Cache.Identities), Humanreadable);
+            Internal::Cache.Load();
+
+            auto Entry = Internal::Cache.Entries.find(Key);
+            if (Entry != Internal::Cache.Entries.end() && Internal::Validate(Range, Entry->second, Pattern, Mask))
+                return Range.first + size_t(Entry->second);
+        }
+
+        size_t Result = _Findpattern(Range, Pattern, Mask);
+        if (!Result) return 0;
+
+        std::lock_guard<std::mutex> Lock(Internal::Cache.Threadguard);
+        Internal::Cache.Entries[Key] = Result - Range.first;
+        Internal::Cache.Dirty = true;
+        return Result;
+    }
+    std::vector<size_t> Findpatternscached(Range_t &Range, const std::vector<std::string> &Humanreadable)
+    {
+        std::vector<size_t> Results(Humanreadable.size());
+        std::vector<Signature_t> Missing;
+        std::vector<size_t> Missingindex;
+        std::vector<uint64_t> Keys;
+
+        {
+            std::lock_guard<std::mutex> Lock(Internal::Cache.Threadguard);
+            const uint64_t Rangekey = Internal::Rangekey(Range, Internal::Cache.Identities);
+            Internal::Cache.Load();
+
+            for (size_t i = 0; i < Humanreadable.size(); ++i)
+            {
+                Signature_t Signature{ Stringtopattern(Humanreadable[i]), Stringtomask(Humanreadable[i]) };
+                uint64_t Key = Internal::Entrykey(Rangekey, Humanreadable[i]);
+
+                auto Entry = Internal::Cache.Entries.find(Key);
+                if (Entry != Internal::Cache.Entries.end() && Internal::Validate(Range, Entry->second, Signature.Pattern, Signature.Mask))
+                {
+                    Results[i] = Range.first + size_t(Entry->second);
+                    continue;
+                }
+
+                Missing.push_back(std::move(Signature));
+                Missingindex.push_back(i);
+                Keys.push_back(Key);
+            }
+        }
+
+        // Only the stale entries are rescanned, in a single pass.
+        if (Missing.empty()) return Results;
+        auto Matches = Findpatterns(Range, Missing);
+
+        std::lock_guard<std::mutex> Lock(Internal::Cache.Threadguard);
+        for (size_t i = 0; i < Missing.size(); ++i)
+        {
+            if (Matches[i].empty()) continue;
+
+            Results[Missingindex[i]] = Matches[i].front();
+            Internal::Cache.Entries[Keys[i]] = Matches[i].front() - Range.first;
+            Internal::Cache.Dirty = true;
+        }
+
+        return Results;
+    }
+    void Savepatterncache()
+    {
+        std::lock_guard<std::mutex> Lock(Internal::Cache.Threadguard);
+        Internal::Cache.Save();
+    }
+}
@@ -3,77 +3,601 @@
     Started: 14-01-2018
     License: MIT
     Notes:
-        Provides a simple scanner for the host image.
-        Should lookinto SSE 4.2 for faster scanning.
+        Provides a simple scanner for the host image and modules.
+        Candidates are found by comparing the two rarest bytes
+        of the pattern with AVX2 or SSE2, selected at runtime.
+        Scalar builds use Horspool for long wildcard-free runs.
 */
 
 #include "../Stdinclude.hpp"
+#include <condition_variable>
+#include <functional>
 
 // GCC exported.
 #if !defined(_WIN32)
 extern char _etext, _end;
 #endif
 
+// Module enumeration.
+#if defined(_WIN32)
+    #include <Psapi.h>
+#elif !defined(__APPLE__)
+    #include <link.h>
+#endif
+
+// SSE2 is part of the x64 baseline, AVX2 is selected at runtime.
+#if defined(__x86_64__) || defined(_M_X64) || ((defined(__i386__) || defined(_M_IX86)) && (defined(__SSE2__) || _M_IX86_FP >= 2))
+    #include <immintrin.h>
+    #define PATTERN_SIMD
+    #if defined(_WIN32)
+        #define PATTERN_TARGET_AVX2
+    #else
+        #define PATTERN_TARGET_AVX2 __attribute__((target("avx2")))
+    #endif
+#endif
+
+static inline uint32_t Bitscanforward(uint32_t Value)
+{
+    #if defined(_WIN32)
+        unsigned long Index;
+        _BitScanForward(&Index, Value);
+        return Index;
+    #else
+        return __builtin_ctz(Value);
+    #endif
+}
+
 namespace Pattern
 {
     // Predefined ranges.
     Range_t Textsegment{};
     Range_t Datasegment{};
 
-    // Find a single pattern in the range.
-    size_t _Findpattern(Range_t &Range, std::vector<uint8_t> Pattern, std::vector<uint8_t> Mask)
+    namespace Internal
     {
-        uint8_t Firstbyte = Pattern[0];
-        auto Base = (const uint8_t *)Range.first;
-        size_t Count = Range.second - Range.first - Pattern.size();
+        // Runtime patterns own their padded storage.
+        struct Compiled_t : Patternview_t
+        {
+            std::vector<uint8_t> Patternstorage, Maskstorage, Skipstorage;
+
+            Compiled_t() = default;
+            Compiled_t(Compiled_t &&) = default;
+            Compiled_t(const Compiled_t &) = delete;
+        };
+        Compiled_t Compile(const std::vector<uint8_t> &Pattern, const std::vector<uint8_t> &Mask)
+        {
+            Compiled_t Result{};
+            Result.Length = std::min(Pattern.size(), Mask.size());
+            Result.Patternstorage.assign((Result.Length + 15) & ~size_t(15), 0);
+            Result.Maskstorage.assign(Result.Patternstorage.size(), 0);
+
+            // Wildcards compare as zero, checked bytes against a full mask.
+            for (size_t i = 0; i < Result.Length; ++i)
+            {
+                Result.Maskstorage[i] = Mask[i] == '\x01' ? 0xFF : 0x00;
+                Result.Patternstorage[i] = Pattern[i] & Result.Maskstorage[i];
+            }
+
+            Result.Pattern = Result.Patternstorage.data();
+            Result.Mask = Result.Maskstorage.data();
+            Selectanchors(Result.Pattern, Result.Mask, Result.Length, Result.Anchor, Result.Second);
+            Selectrun(Result.Mask, Result.Length, Result.Run, Result.Runlength);
+
+            if (Result.Runlength >= PATTERN_HORSPOOL_MINIMUM)
+            {
+                Result.Skipstorage.resize(256);
+                Buildskip(Result.Pattern, Result.Run, Result.Runlength, Result.Skipstorage.data());
+                Result.Skip = Result.Skipstorage.data();
+            }
 
-        // Inline compare.
-        auto Compare = [&](const uint8_t *Address) -> bool
+            return Result;
+        }
+
+        // Masked compare of a candidate, Address + Length <= End.
+        inline bool Verify(const uint8_t *Address, const uint8_t *End, const Patternview_t &Pattern)
         {
-            size_t Patternlength = Pattern.size();
-            for (size_t i = 0; i < Patternlength; ++i)
+            size_t Offset = 0;
+
+            #if defined(PATTERN_SIMD)
+            for (; Offset < Pattern.Length && Address + Offset + 16 <= End; Offset += 16)
             {
-                if (Mask[i] == '\x01' && Address[i] != Pattern[i])
+                __m128i Memory = _mm_loadu_si128((const __m128i *)(Address + Offset));
+                __m128i Mask = _mm_loadu_si128((const __m128i *)(Pattern.Mask + Offset));
+                __m128i Expected = _mm_loadu_si128((const __m128i *)(Pattern.Pattern + Offset));
+                __m128i Equal = _mm_cmpeq_epi8(_mm_and_si128(Memory, Mask), Expected);
+                if (_mm_movemask_epi8(Equal) != 0xFFFF) return false;
+            }
+            #endif
+
+            for (; Offset < Pattern.Length; ++Offset)
+            {
+                if ((Address[Offset] & Pattern.Mask[Offset]) != Pattern.Pattern[Offset])
                     return false;
             }
+
             return true;
+        }
+
+        // Returns the offset of the first match or -1, Count is the number of start positions.
+        size_t Scanscalar(const uint8_t *Base, size_t Count, const Patternview_t &Pattern)
+        {
+            const uint8_t *End = Base + Count + Pattern.Length - 1;
+            uint8_t Anchorbyte = Pattern.Pattern[Pattern.Anchor];
+
+            for (size_t Index = 0; Index < Count; ++Index)
+            {
+                if (likely(Base[Index + Pattern.Anchor] != Anchorbyte))
+                    continue;
+
+                if (Verify(Base + Index, End, Pattern))
+                    return Index;
+            }
+
+            return size_t(-1);
+        }
+
+        #if defined(PATTERN_SIMD)
+        // Compare the two anchors for 16 positions per step.
+        size_t ScanSSE2(const uint8_t *Base, size_t Count, const Patternview_t &Pattern)
+        {
+            const uint8_t *End = Base + Count + Pattern.Length - 1;
+            const __m128i Anchor = _mm_set1_epi8(char(Pattern.Pattern[Pattern.Anchor]));
+            const __m128i Second = _mm_set1_epi8(char(Pattern.Pattern[Pattern.Second]));
+            size_t Index = 0;
+
+            for (; Index + 16 <= Count; Index += 16)
+            {
+                __m128i First = _mm_loadu_si128((const __m128i *)(Base + Index + Pattern.Anchor));
+                __m128i Last = _mm_loadu_si128((const __m128i *)(Base + Index + Pattern.Second));
+                uint32_t Candidates = uint32_t(_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(First, Anchor), _mm_cmpeq_epi8(Last, Second))));
+
+                while (Candidates)
+                {
+                    size_t Offset = Index + Bitscanforward(Candidates);
+                    if (Verify(Base + Offset, End, Pattern)) return Offset;
+                    Candidates &= Candidates - 1;
+                }
+            }
+
+            size_t Result = Scanscalar(Base + Index, Count - Index, Pattern);
+            return Result == size_t(-1) ? Result : Index + Result;
+        }
+
+        // Compare the two anchors for 32 positions per step.
+        PATTERN_TARGET_AVX2 size_t ScanAVX2(const uint8_t *Base, size_t Count, const Patternview_t &Pattern)
+        {
+            const uint8_t *End = Base + Count + Pattern.Length - 1;
+            const __m256i Anchor = _mm256_set1_epi8(char(Pattern.Pattern[Pattern.Anchor]));
+            const __m256i Second = _mm256_set1_epi8(char(Pattern.Pattern[Pattern.Second]));
+            size_t Index = 0;
+
+            for (; Index + 32 <= Count; Index += 32)
+            {
+                __m256i First = _mm256_loadu_si256((const __m256i *)(Base + Index + Pattern.Anchor));
+                __m256i Last = _mm256_loadu_si256((const __m256i *)(Base + Index + Pattern.Second));
+                uint32_t Candidates = uint32_t(_mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(First, Anchor), _mm256_cmpeq_epi8(Last, Second))));
+
+                while (Candidates)
+                {
+                    size_t Offset = Index + Bitscanforward(Candidates);
+                    if (Verify(Base + Offset, End, Pattern)) return Offset;
+                    Candidates &= Candidates - 1;
+                }
+            }
+
+            size_t Result = ScanSSE2(Base + Index, Count - Index, Pattern);
+            return Result == size_t(-1) ? Result : Index + Result;
+        }
+        #endif
+
+        // Select the widest scanner the CPU supports.
+        using Scanner_t = size_t (*)(const uint8_t *Base, size_t Count, const Patternview_t &Pattern);
+        Scanner_t Selectscanner()
+        {
+            #if defined(PATTERN_SIMD)
+                #if defined(_WIN32)
+                    int Registers[4];
+                    __cpuid(Registers, 0);
+                    if (Registers[0] >= 7)
+                    {
+                        __cpuidex(Registers, 7, 0);
+                        bool AVX2 = Registers[1] & (1 << 5);
+                        __cpuid(Registers, 1);
+                        bool OSXSAVE = Registers[2] & (1 << 27);
+                        if (AVX2 && OSXSAVE && (_xgetbv(0) & 6) == 6) return ScanAVX2;
+                    }
+                #else
+                    if (__builtin_cpu_supports("avx2")) return ScanAVX2;
+                #endif
+                return ScanSSE2;
+            #else
+                return Scanscalar;
+            #endif
+        }
+        Scanner_t Scanner()
+        {
+            // Selected on first use, static initializers may already scan.
+            static const Scanner_t Selected = Selectscanner();
+            return Selected;
+        }
+
+        // Shifts on the last byte of the longest wildcard-free run.
+        size_t Scanhorspool(const uint8_t *Base, size_t Count, const Patternview_t &Pattern, const uint8_t *Skip)
+        {
+            const uint8_t *End = Base + Count + Pattern.Length - 1;
+            const uint8_t *Last = Base + Pattern.Run + Pattern.Runlength - 1;
+            uint8_t Lastbyte = Pattern.Pattern[Pattern.Run + Pattern.Runlength - 1];
+
+            for (size_t Index = 0; Index < Count; Index += Skip[Last[Index]])
+            {
+                if (Last[Index] == Lastbyte && Verify(Base + Index, End, Pattern))
+                    return Index;
+            }
+
+            return size_t(-1);
+        }
+
+        // Without SIMD, long wildcard-free runs shift past most of the input with the precomputed table, others use the rarest bytes.
+        struct Strategy_t
+        {
+            Scanner_t Scan;
+            const uint8_t *Skip;
+
+            explicit Strategy_t(const Patternview_t &Pattern) : Scan(Scanner()), Skip(Scan == Scanscalar ? Pattern.Skip : nullptr) {}
+            size_t operator()(const uint8_t *Base, size_t Count, const Patternview_t &Pattern) const
+            {
+                return Skip ? Scanhorspool(Base, Count, Pattern, Skip) : Scan(Base, Count, Pattern);
+            }
+        };
+
+        // Ranges are split into chunks of start positions that the workers take in address order.
+        // Constant-initialized for the same reason, 0 means the hardware concurrency.
+        static std::atomic<size_t> Threadcount{ PATTERN_THREADCOUNT };
+        size_t Workercount()
+        {
+            size_t Count = Threadcount.load(std::memory_order_relaxed);
+            return Count ? Count : std::max(size_t(std::thread::hardware_concurrency()), size_t(1));
+        }
+        constexpr size_t Minimumchunk = 1024 * 1024;
+        size_t Chunksize(size_t Total)
+        {
+            return std::max(Minimumchunk, Total / (Workercount() * 4) + 1);
+        }
+
+        // Helpers are started on first use and never exit. The caller works as well and only waits
+        // for helpers that claimed the job, so a scan under the loader lock finishes on its own.
+        struct Workerpool_t
+        {
+            std::condition_variable Wakeup, Finished;
+            const std::function<void()> *Job{};
+            size_t Generation{}, Claimed{}, Wanted{}, Running{}, Started{};
+            std::mutex Runguard, Threadguard;
+
+            void Loop()
+            {
+                std::unique_lock<std::mutex> Lock(Threadguard);
+                for (size_t Seen = 0;; )
+                {
+                    Wakeup.wait(Lock, [&]() { return Generation != Seen && Claimed < Wanted; });
+                    Seen = Generation;
+                    ++Claimed; ++Running;
+
+                    const auto Work = Job;
+                    Lock.unlock();
+                    (*Work)();
+                    Lock.lock();
+
+                    if (0 == --Running) Finished.notify_all();
+                }
+            }
+            void Run(size_t Helpers, const std::function<void()> &Work)
+            {
+                // Concurrent scans run on their own thread rather than queueing.
+                std::unique_lock<std::mutex> Exclusive(Runguard, std::try_to_lock);
+                if (!Exclusive) return Work();
+
+                {
+                    std::lock_guard<std::mutex> Lock(Threadguard);
+                    try { for (; Started < Helpers; ++Started) std::thread(&Workerpool_t::Loop, this).detach(); }
+                    catch (const std::system_error &) {}
+
+                    Job = &Work;
+                    Claimed = 0;
+                    Wanted = std::min(Helpers, Started);
+                    ++Generation;
+                }
+                Wakeup.notify_all();
+
+                Work();
+
+                // All chunks are taken, late helpers must not claim the job.
+                std::unique_lock<std::mutex> Lock(Threadguard);
+                Wanted = Claimed;
+                Finished.wait(Lock, [&]() { return 0 == Running; });
+                Job = nullptr;
+            }
+        };
+        static Workerpool_t &Workerpool()
+        {
+            // Never destroyed as the helpers outlive static destruction.
+            static auto Pool = new Workerpool_t();
+            return *Pool;
+        }
+
+        template <typename Function> void Parallelchunks(size_t Total, size_t Size, Function &&Callback)
+        {
+            size_t Chunkcount = (Total + Size - 1) / Size;
+            std::atomic<size_t> Next{ 0 };
+
+            const std::function<void()> Worker = [&]()
+            {
+                for (size_t Chunk = Next++; Chunk < Chunkcount; Chunk = Next++)
+                    Callback(Chunk, Chunk * Size, std::min(Total, (Chunk + 1) * Size));
+            };
+
+            const size_t Helpers = std::min(Workercount(), Chunkcount) - 1;
+            if (0 == Helpers) Worker();
+            else Workerpool().Run(Helpers, Worker);
+        }
+
+        // Number of positions where the whole pattern fits.
+        size_t Startcount(size_t Start, size_t End, const Patternview_t &Pattern)
+        {
+            if (End < Start || End - Start < Pattern.Length) return 0;
+            return End - Start - Pattern.Length + 1;
+        }
+        bool Haswildcardsonly(const Patternview_t &Pattern)
+        {
+            return std::find(Pattern.Mask, Pattern.Mask + Pattern.Length, 0xFF) == Pattern.Mask + Pattern.Length;
+        }
+
+        // Batch scanning, signatures are bucketed by a hash of their rarest run of 4 checked bytes or 2 if they have none.
+        struct Entry_t { uint32_t Signature, Offset, Anchor; };
+        struct Table_t
+        {
+            std::vector<uint32_t> Bucketstart = std::vector<uint32_t>(0x10001);
+            std::vector<uint64_t> Bitmap = std::vector<uint64_t>(0x10000 / 64);
+            std::vector<Entry_t> Entries;
+            std::vector<std::pair<uint32_t, Entry_t>> Pending;
+
+            bool Contains(uint32_t Key) const { return Bitmap[Key / 64] & (uint64_t(1) << (Key % 64)); }
+            void Build()
+            {
+                for (auto &Item : Pending) ++Bucketstart[Item.first + 1];
+                for (size_t i = 1; i < Bucketstart.size(); ++i) Bucketstart[i] += Bucketstart[i - 1];
+
+                auto Fill = Bucketstart;
+                Entries.resize(Pending.size());
+                for (auto &Item : Pending)
+                {
+                    Entries[Fill[Item.first]++] = Item.second;
+                    Bitmap[Item.first / 64] |= uint64_t(1) << (Item.first % 64);
+                }
+            }
+        };
+        inline uint32_t Wideword(const uint8_t *Address)
+        {
+            uint32_t Word;
+            std::memcpy(&Word, Address, sizeof(uint32_t));
+            return Word;
+        }
+        inline uint32_t Narrowword(const uint8_t *Address)
+        {
+            return Address[0] | (Address[1] << 8);
+        }
+        inline uint32_t Widekey(uint32_t Word)
+        {
+            return (Word * 0x9E3779B1U) >> 16;
+        }
+        struct Batch_t
+        {
+            std::vector<Compiled_t> Compiled;
+            std::vector<size_t> Unanchored;
+            Table_t Wide, Narrow;
+
+            Batch_t(const std::vector<Signature_t> &Signatures)
+            {
+                Compiled.reserve(Signatures.size());
+                for (size_t i = 0; i < Signatures.size(); ++i)
+                {
+                    Compiled.push_back(Compile(Signatures[i].Pattern, Signatures[i].Mask));
+                    const auto &Pattern = Compiled.back();
+
+                    // Rarest run of Width checked bytes, or Length if there is none.
+                    auto Bestrun = [&](size_t Width) -> size_t
+                    {
+                        size_t Best = Pattern.Length, Bestcost = size_t(-1);
+                        for (size_t k = 0; k + Width <= Pattern.Length; ++k)
+                        {
+                            size_t Cost = 0, n = 0;
+                            for (; n < Width && Pattern.Mask[k + n]; ++n) Cost += Bytefrequency[Pattern.Pattern[k + n]];
+                            if (n == Width && Cost < Bestcost) { Bestcost = Cost; Best = k; }
+                        }
+                        return Best;
+                    };
+
+                    size_t Offset = Bestrun(4);
+                    if (Offset != Pattern.Length)
+                    {
+                        uint32_t Anchor = Wideword(Pattern.Pattern + Offset);
+                        Wide.Pending.push_back({ Widekey(Anchor), { uint32_t(i), uint32_t(Offset), Anchor } });
+                        continue;
+                    }
+
+                    Offset = Bestrun(2);
+                    if (Offset != Pattern.Length)
+                    {
+                        uint32_t Anchor = Narrowword(Pattern.Pattern + Offset);
+                        Narrow.Pending.push_back({ Anchor, { uint32_t(i), uint32_t(Offset), Anchor } });
+                        continue;
+                    }
+
+                    Unanchored.push_back(i);
+                }
+
+                Wide.Build();
+                Narrow.Build();
+            }
+
+            // Check the anchors at positions [First, Last) of the range, reading past Last as needed.
+            void Scan(const uint8_t *Base, size_t Size, size_t First, size_t Last, std::vector<std::vector<size_t>> &Results) const
+            {
+                auto Lookup = [&](const Table_t &Table, uint32_t Key, uint32_t Word, size_t Index)
+                {
+                    for (uint32_t e = Table.Bucketstart[Key]; e < Table.Bucketstart[Key + 1]; ++e)
+                    {
+                        const auto &Entry = Table.Entries[e];
+                        if (Entry.Anchor != Word) continue;
+
+                        const auto &Pattern = Compiled[Entry.Signature];
+                        if (Index < Entry.Offset || Size - (Index - Entry.Offset) < Pattern.Length) continue;
+                        if (Verify(Base + Index - Entry.Offset, Base + Size, Pattern))
+                            Results[Entry.Signature].push_back(size_t(Base) + Index - Entry.Offset);
+                    }
+                };
+
+                // The bitmaps keep the hot loop in L1.
+                const uint64_t *Widebits = Wide.Bitmap.data(), *Narrowbits = Narrow.Bitmap.data();
+                bool Hasnarrow = !Narrow.Entries.empty();
+                size_t Index = First;
+
+                for (; Index < Last && Index + 3 < Size; ++Index)
+                {
+                    uint32_t Word = Wideword(Base + Index), Key = Widekey(Word);
+                    if (unlikely(Widebits[Key / 64] & (uint64_t(1) << (Key % 64)))) Lookup(Wide, Key, Word, Index);
+
+                    if (Hasnarrow)
+                    {
+                        Word &= 0xFFFF;
+                        if (unlikely(Narrowbits[Word / 64] & (uint64_t(1) << (Word % 64)))) Lookup(Narrow, Word, Word, Index);
+                    }
+                }
+                for (; Hasnarrow && Index < Last && Index + 1 < Size; ++Index)
+                {
+                    uint32_t Word = Narrowword(Base + Index);
+                    if (unlikely(Narrow.Contains(Word))) Lookup(Narrow, Word, Word, Index);
+                }
+            }
         };
+    }
+
+    // Scanning is split over this many threads, 0 selects the hardware concurrency.
+    void Setthreadcount(size_t Count)
+    {
+        Internal::Threadcount.store(Count, std::memory_order_relaxed);
+    }
 
+    // Find a single pattern in the range.
+    size_t _Findpattern(Range_t &Range, const std::vector<uint8_t> &Pattern, const std::vector<uint8_t> &Mask)
+    {
         // We could do a runtime check for Pattern < Mask.
         assert(Pattern.size() == Mask.size());
 
-        // Iterate over the range.
-        for (size_t Index = 0; Index < Count; ++Index)
+        return _Findpattern(Range, Internal::Compile(Pattern, Mask));
+    }
+    size_t _Findpattern(Range_t &Range, const Patternview_t &Compiled)
+    {
+        size_t Count = Internal::Startcount(Range.first, Range.second, Compiled);
+        if (Count == 0) return 0;
+        if (Internal::Haswildcardsonly(Compiled)) return Range.first;
+
+        // Chunks read Length - 1 bytes past their end, so straddling matches are found by the chunk they start in.
+        Internal::Strategy_t Scan(Compiled);
+        size_t Chunksize = Internal::Chunksize(Count);
+        std::vector<size_t> Chunkresults((Count + Chunksize - 1) / Chunksize, size_t(-1));
+        std::atomic<size_t> Firstchunk{ size_t(-1) };
+
+        Internal::Parallelchunks(Count, Chunksize, [&](size_t Chunk, size_t First, size_t Last)
         {
-            if (likely(Base[Index] != Firstbyte))
-                continue;
+            // Chunks after an earlier match are skipped.
+            if (Chunk > Firstchunk.load(std::memory_order_relaxed)) return;
 
-            if (Compare(Base + Index))
-                return Range.first + Index;
-        }
+            size_t Offset = Scan((const uint8_t *)Range.first + First, Last - First, Compiled);
+            if (Offset == size_t(-1)) return;
+
+            Chunkresults[Chunk] = First + Offset;
+            size_t Current = Firstchunk.load();
+            while (Chunk < Current && !Firstchunk.compare_exchange_weak(Current, Chunk));
+        });
 
-        return 0;
+        size_t Chunk = Firstchunk.load();
+        return Chunk == size_t(-1) ? 0 : Range.first + Chunkresults[Chunk];
     }
 
     // Scan until the end of the range and return all result.
-    std::vector<size_t> Findpatterns(Range_t &Range, std::vector<uint8_t> Pattern, std::vector<uint8_t> Mask)
+    std::vector<size_t> Findpatterns(Range_t &Range, const std::vector<uint8_t> &Pattern, const std::vector<uint8_t> &Mask)
     {
+        return Findpatterns(Range, Internal::Compile(Pattern, Mask));
+    }
+    std::vector<size_t> Findpatterns(Range_t &Range, const Patternview_t &Compiled)
+    {
+        size_t Count = Internal::Startcount(Range.first, Range.second, Compiled);
+        bool Wildcardsonly = Internal::Haswildcardsonly(Compiled);
+        Internal::Strategy_t Scan(Compiled);
         std::vector<std::size_t> Results;
-        Range_t Localrange = Range;
-        size_t Lastresult = 0;
+        if (Count == 0) return Results;
+
+        size_t Chunksize = Internal::Chunksize(Count);
+        std::vector<std::vector<size_t>> Chunkresults((Count + Chunksize - 1) / Chunksize);
 
-        while (true)
+        Internal::Parallelchunks(Count, Chunksize, [&](size_t Chunk, size_t First, size_t Last)
         {
-            Lastresult = _Findpattern(Localrange, Pattern, Mask);
+            for (size_t Index = First; Index < Last; ++Index)
+            {
+                if (!Wildcardsonly)
+                {
+                    size_t Offset = Scan((const uint8_t *)Range.first + Index, Last - Index, Compiled);
+                    if (Offset == size_t(-1)) break;
+                    Index += Offset;
+                }
 
-            if (Lastresult == 0)
-                break;
+                Chunkresults[Chunk].push_back(Range.first + Index);
+            }
+        });
 
-            Localrange.first = Lastresult + 1;
-            Results.push_back(Lastresult);
-        }
+        // Chunks are in address order.
+        for (auto &Chunk : Chunkresults) Results.insert(Results.end(), Chunk.begin(), Chunk.end());
+        return Results;
+    }
 
-        return std::move(Results);
+    // Find every signature in a single pass over the range, returns the matches per signature.
+    std::vector<std::vector<size_t>> Findpatterns(Range_t &Range, const std::vector<Signature_t> &Signatures)
+    {
+        std::vector<std::vector<size_t>> Results(Signatures.size());
+        if (Range.second <= Range.first) return Results;
+
+        Internal::Batch_t Batch(Signatures);
+        for (auto &Index : Batch.Unanchored)
+            Results[Index] = Findpatterns(Range, Signatures[Index].Pattern, Signatures[Index].Mask);
+
+        // Each match is found by the chunk holding its anchor, scans read past the chunk as needed.
+        auto Base = (const uint8_t *)Range.first;
+        size_t Size = Range.second - Range.first;
+        size_t Chunksize = Internal::Chunksize(Size);
+        std::vector<std::vector<std::vector<size_t>>> Chunkresults((Size + Chunksize - 1) / Chunksize);
+
+        Internal::Parallelchunks(Size, Chunksize, [&](size_t Chunk, size_t First, size_t Last)
+        {
+            Chunkresults[Chunk].resize(Signatures.size());
+            Batch.Scan(Base, Size, First, Last, Chunkresults[Chunk]);
+        });
+
+        // A signature's anchor is at a fixed offset, so chunk order is address order.
+        for (auto &Chunk : Chunkresults)
+            for (size_t i = 0; i < Chunk.size(); ++i)
+                Results[i].insert(Results[i].end(), Chunk[i].begin(), Chunk[i].end());
+
+        return Results;
+    }
+    std::vector<std::vector<size_t>> Findpatterns(Range_t &Range, const std::vector<std::string> &Humanreadable)
+    {
+        std::vector<Signature_t> Signatures;
+        Signatures.reserve(Humanreadable.size());
+
+        for (auto &Item : Humanreadable)
+            Signatures.push_back({ Stringtopattern(Item), Stringtomask(Item) });
+
+        return Findpatterns(Range, Signatures);
     }
 
     // Create a pattern or mask from a readable string.
@@ -112,6 +636,112 @@ namespace Pattern
         return std::move(Result);
     }
 
+    // Loaded modules, indexed in a single pass.
+    namespace Internal
+    {
+        static std::vector<Module_t> Moduleindex;
+        static std::mutex Moduleguard;
+
+        // The largest executable and writable blocks of a module.
+        void Addsegment(Module_t &Module, size_t Start, size_t Size, bool Executable, bool Writable)
+        {
+            auto &Segment = Executable ? Module.Textsegment : Module.Datasegment;
+            if (!Executable && !Writable) return;
+
+            if (Size > Segment.second - Segment.first)
+                Segment = { Start, Start + Size };
+        }
+    }
+    void Updatemodules()
+    {
+        std::vector<Module_t> Modules;
+
+    #if defined(_WIN32)
+        HMODULE Handles[1024];
+        DWORD Needed = 0;
+        if (!EnumProcessModules(GetCurrentProcess(), Handles, sizeof(Handles), &Needed)) return;
+
+        for (size_t i = 0; i < std::min(size_t(Needed / sizeof(HMODULE)), std::size(Handles)); ++i)
+        {
+            char Path[MAX_PATH]{};
+            Module_t Module{};
+            Module.Base = size_t(Handles[i]);
+            if (GetModuleFileNameA(Handles[i], Path, MAX_PATH)) Module.Name = Path;
+
+            PIMAGE_DOS_HEADER DOSHeader = (PIMAGE_DOS_HEADER)Handles[i];
+            PIMAGE_NT_HEADERS NTHeader = (PIMAGE_NT_HEADERS)((DWORD_PTR)Handles[i] + DOSHeader->e_lfanew);
+            PIMAGE_SECTION_HEADER Section = IMAGE_FIRST_SECTION(NTHeader);
+
+            for (WORD k = 0; k < NTHeader->FileHeader.NumberOfSections; ++k, ++Section)
+            {
+                Internal::Addsegment(Module, Module.Base + Section->VirtualAddress, Section->Misc.VirtualSize,
+                    Section->Characteristics & IMAGE_SCN_MEM_EXECUTE, Section->Characteristics & IMAGE_SCN_MEM_WRITE);
+            }
+
+            Modules.push_back(std::move(Module));
+        }
+    #elif !defined(__APPLE__)
+        dl_iterate_phdr([](struct dl_phdr_info *Info, size_t, void *Userdata) -> int
+        {
+            auto Modules = reinterpret_cast<std::vector<Module_t> *>(Userdata);
+            Module_t Module{};
+            Module.Base = size_t(Info->dlpi_addr);
+            Module.Name = Info->dlpi_name ? Info->dlpi_name : "";
+
+            // The host is listed first without a name.
+            if (Modules->empty() && Module.Name.empty())
+            {
+                char Path[4096]{};
+                auto Length = readlink("/proc/self/exe", Path, sizeof(Path) - 1);
+                if (Length > 0) Module.Name.assign(Path, size_t(Length));
+            }
+
+            for (size_t i = 0; i < Info->dlpi_phnum; ++i)
+            {
+                const auto &Header = Info->dlpi_phdr[i];
+                if (Header.p_type != PT_LOAD) continue;
+
+                Internal::Addsegment(Module, Module.Base + Header.p_vaddr, Header.p_memsz, Header.p_flags & PF_X, Header.p_flags & PF_W);
+            }
+
+            Modules->push_back(std::move(Module));
+            return 0;
+        }, &Modules);
+    #else
+        // Only our own image.
+        Module_t Module{};
+        Module.Base = *(size_t *)dlopen(NULL, RTLD_LAZY);
+        Module.Textsegment = { Module.Base, size_t(&_etext) };
+        Module.Datasegment = { size_t(&_etext), size_t(&_end) };
+        Modules.push_back(std::move(Module));
+    #endif
+
+        std::lock_guard<std::mutex> Lock(Internal::Moduleguard);
+        Internal::Moduleindex = std::move(Modules);
+    }
+    std::vector<Module_t> Modules()
+    {
+        std::lock_guard<std::mutex> Lock(Internal::Moduleguard);
+        return Internal::Moduleindex;
+    }
+    Module_t Findmodule(std::string_view Name)
+    {
+        std::lock_guard<std::mutex> Lock(Internal::Moduleguard);
+        if (Name.empty()) return Internal::Moduleindex.empty() ? Module_t{} : Internal::Moduleindex.front();
+
+        for (auto &Module : Internal::Moduleindex)
+        {
+            std::string_view Path = Module.Name;
+            if (Path == Name) return Module;
+
+            // Compare the filename.
+            size_t Separator = Path.find_last_of("/\\");
+            if (Separator != std::string_view::npos && Path.substr(Separator + 1) == Name) return Module;
+        }
+
+        return {};
+    }
+
     // Fetch the segment information on startup.
     void Updatesegments()
     {
@@ -140,6 +770,10 @@ namespace Pattern
 
         Datasegment.first = Textsegment.second;
         Datasegment.second = Datasegment.first + NTHeader->OptionalHeader.SizeOfInitializedData;
+    #elif !defined(__APPLE__)
+        auto Host = Findmodule("");
+        Textsegment = Host.Textsegment;
+        Datasegment = Host.Datasegment;
     #else
         Textsegment.first = *(size_t *)dlopen(NULL, RTLD_LAZY);
         Textsegment.second = size_t(&_etext);
@@ -147,6 +781,6 @@ namespace Pattern
         Datasegment.second = size_t(&_end);
     #endif
     }
-    struct Startup { Startup() { Updatesegments(); }; };
+    struct Startup { Startup() { Updatemodules(); Updatesegments(); }; };
     static Startup Updater{};
 }
@@ -3,8 +3,12 @@
     Started: 14-01-2018
     License: MIT
     Notes:
-        Provides a simple scanner for the host image.
-        Should lookinto SSE 4.2 for faster scanning.
+        Provides a simple scanner for the host image and modules.
+        Candidates are found by comparing the two rarest bytes
+        of the pattern with AVX2 or SSE2, selected at runtime.
+        Scalar builds use Horspool for long wildcard-free runs.
+        Large ranges are split into chunks over a few threads.
+        Results can be cached in the plugins archive between runs.
 */
 
 #pragma once
@@ -16,11 +20,177 @@ namespace Pattern
     extern Range_t Textsegment;
     extern Range_t Datasegment;
 
+    // Loaded modules with their largest executable and writable blocks.
+    struct Module_t
+    {
+        std::string Name;
+        size_t Base{};
+        Range_t Textsegment{}, Datasegment{};
+    };
+
+    // The index is built on startup, update it after loading libraries.
+    void Updatemodules();
+    std::vector<Module_t> Modules();
+
+    // Matches the path or filename, an empty name is the host, unknown modules have empty ranges.
+    Module_t Findmodule(std::string_view Name);
+
+    // Padded pattern prepared for scanning, wildcards are zero in both arrays.
+    struct Patternview_t
+    {
+        const uint8_t *Pattern{}, *Mask{};
+        size_t Length{}, Anchor{}, Second{};
+        size_t Run{}, Runlength{};
+
+        // Horspool shifts for the run, only set when it is at least PATTERN_HORSPOOL_MINIMUM long.
+        const uint8_t *Skip{};
+    };
+
+    namespace Internal
+    {
+        // Relative frequency of each byte in x86-64 .text, log-scaled.
+        // Sampled from libc, libstdc++, libcrypto, gcc and git.
+        constexpr uint8_t Bytefrequency[256] =
+        {
+            255, 208, 184, 179, 189, 185, 165, 169, 200, 168, 160, 158, 171, 166, 156, 226,
+            194, 166, 157, 157, 169, 172, 155, 155, 183, 151, 146, 147, 155, 152, 162, 200,
+            182, 156, 147, 147, 218, 168, 143, 143, 182, 174, 140, 157, 151, 151, 169, 145,
+            173, 208, 141, 156, 155, 170, 138, 140, 172, 177, 145, 153, 159, 177, 139, 148,
+            185, 209, 152, 168, 206, 190, 153, 162, 241, 197, 148, 147, 210, 177, 145, 145,
+            173, 142, 139, 173, 179, 177, 158, 159, 159, 137, 138, 174, 173, 179, 157, 154,
+            159, 135, 151, 161, 169, 141, 200, 136, 157, 138, 140, 142, 159, 141, 152, 167,
+            159, 137, 155, 155, 195, 182, 146, 150, 162, 141, 139, 154, 173, 155, 152, 161,
+            182, 164, 145, 206, 203, 208, 143, 151, 164, 230, 133, 219, 149, 208, 144, 144,
+            173, 133, 134, 144, 156, 149, 133, 134, 151, 133, 130, 133, 144, 136, 131, 135,
+            150, 134, 130, 135, 141, 135, 131, 132, 150, 133, 135, 140, 146, 133, 132, 139,
+            148, 135, 132, 137, 148, 140, 169, 141, 168, 151, 168, 145, 155, 149, 176, 163,
+            206, 184, 170, 187, 182, 179, 174, 188, 163, 174, 155, 146, 146, 150, 149, 147,
+            169, 158, 182, 153, 150, 151, 150, 153, 165, 152, 155, 165, 148, 149, 162, 178,
+            171, 159, 161, 147, 157, 152, 163, 167, 215, 194, 164, 179, 171, 168, 169, 182,
+            170, 156, 161, 176, 154, 162, 185, 173, 180, 165, 177, 173, 169, 176, 185, 235
+        };
+
+        // The two rarest checked bytes filter the candidates.
+        constexpr void Selectanchors(const uint8_t *Pattern, const uint8_t *Mask, size_t Length, size_t &Anchor, size_t &Second)
+        {
+            size_t Rarest = Length, Secondrarest = Length;
+            for (size_t i = 0; i < Length; ++i)
+            {
+                if (!Mask[i]) continue;
+
+                if (Rarest == Length || Bytefrequency[Pattern[i]] < Bytefrequency[Pattern[Rarest]])
+                {
+                    Secondrarest = Rarest;
+                    Rarest = i;
+                }
+                else if (Secondrarest == Length || Bytefrequency[Pattern[i]] < Bytefrequency[Pattern[Secondrarest]])
+                {
+                    Secondrarest = i;
+                }
+            }
+
+            Anchor = Rarest == Length ? 0 : Rarest;
+            Second = Secondrarest == Length ? Anchor : Secondrarest;
+        }
+
+        // The longest run without wildcards, capped so Horspool shifts fit in a byte.
+        constexpr void Selectrun(const uint8_t *Mask, size_t Length, size_t &Run, size_t &Runlength)
+        {
+            Run = 0; Runlength = 0;
+            for (size_t i = 0, Start = 0; i < Length; ++i)
+            {
+                if (!Mask[i]) { Start = i + 1; continue; }
+                if (i + 1 - Start > Runlength) { Run = Start; Runlength = i + 1 - Start; }
+            }
+
+            if (Runlength > 255) { Run += Runlength - 255; Runlength = 255; }
+        }
+
+        // Shift by the distance from the last occurrence of each byte to the end of the run.
+        constexpr void Buildskip(const uint8_t *Pattern, size_t Run, size_t Runlength, uint8_t *Skip)
+        {
+            for (size_t i = 0; i < 256; ++i) Skip[i] = uint8_t(Runlength);
+            for (size_t i = 0; i + 1 < Runlength; ++i) Skip[Pattern[Run + i]] = uint8_t(Runlength - 1 - i);
+        }
+
+        // Not constexpr, so a literal with an invalid or unpaired digit fails to compile.
+        inline void Invalidhexdigit() {}
+        constexpr uint8_t Hexnibble(char Character)
+        {
+            if (Character >= '0' && Character <= '9') return uint8_t(Character - '0');
+            if (Character >= 'a' && Character <= 'f') return uint8_t(Character - 'a' + 10);
+            if (Character >= 'A' && Character <= 'F') return uint8_t(Character - 'A' + 10);
+
+            Invalidhexdigit();
+            return 0;
+        }
+
+        // Findpattern() parses quoted arguments at compile-time, anything else goes through Stringtopattern.
+        constexpr bool Isquoted(const char *Token)
+        {
+            return Token[0] == '"';
+        }
+        template <typename Tag, size_t N> constexpr const char (&Literalarray(const char (&Humanreadable)[N]))[N]
+        {
+            return Humanreadable;
+        }
+    }
+
+    // Pattern parsed at compile-time, storage is padded to whole vectors.
+    template <size_t Size> struct Literal_t
+    {
+        uint8_t Pattern[Size]{}, Mask[Size]{}, Skip[256]{};
+        size_t Length{}, Anchor{}, Second{};
+        size_t Run{}, Runlength{};
+
+        constexpr Patternview_t View() const
+        {
+            return { Pattern, Mask, Length, Anchor, Second, Run, Runlength, Runlength >= PATTERN_HORSPOOL_MINIMUM ? Skip : nullptr };
+        }
+    };
+    template <size_t N> constexpr auto Makeliteral(const char (&Humanreadable)[N])
+    {
+        Literal_t<(N + 15) & ~size_t(15)> Result{};
+
+        // Same format as Stringtopattern.
+        for (size_t i = 0; i + 1 < N && Humanreadable[i]; ++i)
+        {
+            if (Humanreadable[i] == ' ') continue;
+            if (Humanreadable[i] == '?') { ++Result.Length; continue; }
+
+            Result.Mask[Result.Length] = 0xFF;
+            Result.Pattern[Result.Length++] = uint8_t(Internal::Hexnibble(Humanreadable[i]) << 4 | Internal::Hexnibble(Humanreadable[i + 1]));
+            ++i;
+        }
+
+        Internal::Selectanchors(Result.Pattern, Result.Mask, Result.Length, Result.Anchor, Result.Second);
+        Internal::Selectrun(Result.Mask, Result.Length, Result.Run, Result.Runlength);
+        if (Result.Runlength >= PATTERN_HORSPOOL_MINIMUM) Internal::Buildskip(Result.Pattern, Result.Run, Result.Runlength, Result.Skip);
+        return Result;
+    }
+
+    // Scanning is split over this many threads, 0 selects the hardware concurrency.
+    // Defaults to PATTERN_THREADCOUNT, helper threads are started on the first large scan.
+    void Setthreadcount(size_t Count);
+
     // Find a single pattern in the range.
-    size_t _Findpattern(Range_t &Range, std::vector<uint8_t> Pattern, std::vector<uint8_t> Mask);
+    size_t _Findpattern(Range_t &Range, const std::vector<uint8_t> &Pattern, const std::vector<uint8_t> &Mask);
+    size_t _Findpattern(Range_t &Range, const Patternview_t &Pattern);
 
     // Scan until the end of the range and return all result.
-    std::vector<size_t> Findpatterns(Range_t &Range, std::vector<uint8_t> Pattern, std::vector<uint8_t> Mask);
+    std::vector<size_t> Findpatterns(Range_t &Range, const std::vector<uint8_t> &Pattern, const std::vector<uint8_t> &Mask);
+    std::vector<size_t> Findpatterns(Range_t &Range, const Patternview_t &Pattern);
+
+    // Find every signature in a single pass over the range, returns the matches per signature.
+    struct Signature_t { std::vector<uint8_t> Pattern, Mask; };
+    std::vector<std::vector<size_t>> Findpatterns(Range_t &Range, const std::vector<Signature_t> &Signatures);
+    std::vector<std::vector<size_t>> Findpatterns(Range_t &Range, const std::vector<std::string> &Humanreadable);
+
+    // Scans through a cache in the plugins archive, cached addresses are re-checked before use.
+    // New entries are only written by Savepatterncache(), call it outside of DllMain and static destructors.
+    size_t Findpatterncached(Range_t &Range, const std::string &Humanreadable);
+    std::vector<size_t> Findpatternscached(Range_t &Range, const std::vector<std::string> &Humanreadable);
+    void Savepatterncache();
 
     // Create a pattern or mask from a readable string.
     std::vector<uint8_t> Stringtopattern(std::string Humanreadable);
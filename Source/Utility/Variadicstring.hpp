@@ -4,20 +4,169 @@
     License: MIT
     Notes:
         Creates a readable string from variadic input.
+        va() never truncates, vaview() reuses a per-thread buffer,
+        and vaformat() is a typed alternative using {} placeholders.
 */
 
 #pragma once
 #include "../Stdinclude.hpp"
 
+// Append the formatted string to the output, growing it as needed.
+inline void vaappendv(std::string &Output, std::string_view Format, std::va_list Varlist)
+{
+    size_t Offset = Output.size();
+    size_t Sparesize = std::max(Output.capacity() - Offset, size_t(255));
+    std::va_list Copiedlist;
+
+    // Try to format into the spare capacity, std::string always has room for the terminator.
+    Output.resize(Offset + Sparesize);
+    va_copy(Copiedlist, Varlist);
+    int Length = std::vsnprintf(Output.data() + Offset, Sparesize + 1, Format.data(), Copiedlist);
+    va_end(Copiedlist);
+
+    // Encoding errors leave the output untouched.
+    if (Length < 0)
+    {
+        Output.resize(Offset);
+        return;
+    }
+
+    // Grow to the exact size and format again.
+    if (size_t(Length) > Sparesize)
+    {
+        Output.resize(Offset + Length);
+        std::vsnprintf(Output.data() + Offset, Length + 1, Format.data(), Varlist);
+        return;
+    }
+
+    Output.resize(Offset + Length);
+}
+inline void vaappend(std::string &Output, std::string_view Format, ...)
+{
+    std::va_list Varlist;
+
+    va_start(Varlist, Format);
+    vaappendv(Output, Format, Varlist);
+    va_end(Varlist);
+}
+
+// Format on the stack, only long strings take a second pass.
 inline std::string va(std::string_view Format, ...)
 {
-    auto Resultbuffer = std::make_unique<char[]>(2048);
+    char Stackbuffer[1024];
+    std::va_list Varlist, Copiedlist;
+
+    va_start(Varlist, Format);
+    va_copy(Copiedlist, Varlist);
+    int Length = std::vsnprintf(Stackbuffer, sizeof(Stackbuffer), Format.data(), Copiedlist);
+    va_end(Copiedlist);
+
+    std::string Result;
+    if (Length >= 0 && size_t(Length) < sizeof(Stackbuffer))
+    {
+        Result.assign(Stackbuffer, Length);
+    }
+    else if (Length > 0)
+    {
+        Result.resize(Length);
+        std::vsnprintf(Result.data(), Length + 1, Format.data(), Varlist);
+    }
+    va_end(Varlist);
+
+    return Result;
+}
+
+// Format into a per-thread buffer, valid until the next vaview() on this thread.
+namespace Internal { inline thread_local std::string Vabuffer; }
+inline std::string_view vaview(std::string_view Format, ...)
+{
     std::va_list Varlist;
 
-    // Create a new string from the arguments and truncate as needed.
+    Internal::Vabuffer.clear();
+    va_start(Varlist, Format);
+    vaappendv(Internal::Vabuffer, Format, Varlist);
+    va_end(Varlist);
+
+    return Internal::Vabuffer;
+}
+
+// Format into the callers buffer, output that does not fit goes to the vaview() buffer.
+inline std::string_view vainto(char *Buffer, size_t Buffersize, std::string_view Format, ...)
+{
+    std::va_list Varlist, Copiedlist;
+
     va_start(Varlist, Format);
-    std::vsnprintf(Resultbuffer.get(), 2048, Format.data(), Varlist);
+    va_copy(Copiedlist, Varlist);
+    int Length = std::vsnprintf(Buffer, Buffersize, Format.data(), Copiedlist);
+    va_end(Copiedlist);
+
+    std::string_view Result{};
+    if (Length >= 0 && size_t(Length) < Buffersize)
+    {
+        Result = { Buffer, size_t(Length) };
+    }
+    else if (Length > 0)
+    {
+        Internal::Vabuffer.clear();
+        vaappendv(Internal::Vabuffer, Format, Varlist);
+        Result = Internal::Vabuffer;
+    }
     va_end(Varlist);
 
-    return std::move(Resultbuffer.get());
+    return Result;
+}
+
+// Typed formatting where every {} is replaced by the next argument.
+namespace Internal
+{
+    template <typename Type> inline void Vaformatargument(std::string &Output, const Type &Value)
+    {
+        char Buffer[64];
+
+        if constexpr (std::is_same_v<Type, bool>)
+            Output.append(Value ? "true" : "false");
+        else if constexpr (std::is_same_v<Type, char>)
+            Output.push_back(Value);
+        else if constexpr (std::is_same_v<Type, const char *> || std::is_same_v<Type, char *>)
+            Output.append(Value ? Value : "(null)");
+        else if constexpr (std::is_convertible_v<const Type &, std::string_view>)
+            Output.append(std::string_view(Value));
+        else if constexpr (std::is_enum_v<Type>)
+            Vaformatargument(Output, std::underlying_type_t<Type>(Value));
+        else if constexpr (std::is_pointer_v<Type>)
+        {
+            auto Result = std::to_chars(Buffer, Buffer + sizeof(Buffer), uintptr_t(Value), 16);
+            Output.append("0x").append(Buffer, Result.ptr - Buffer);
+        }
+        else
+        {
+            static_assert(std::is_arithmetic_v<Type>, "vaformat() only handles strings, arithmetic types and pointers.");
+            auto Result = std::to_chars(Buffer, Buffer + sizeof(Buffer), Value);
+            Output.append(Buffer, Result.ptr - Buffer);
+        }
+    }
+}
+template <typename ... Args>
+inline void vaformatappend(std::string &Output, std::string_view Format, const Args & ... Arguments)
+{
+    auto Appendnext = [&](const auto &Value)
+    {
+        size_t Placeholder = Format.find("{}");
+        Output.append(Format.substr(0, Placeholder));
+        if (Placeholder == std::string_view::npos) { Format = {}; return; }
+
+        Internal::Vaformatargument(Output, Value);
+        Format.remove_prefix(Placeholder + 2);
+    };
+
+    (Appendnext(Arguments), ...);
+    Output.append(Format);
+}
+template <typename ... Args>
+inline std::string vaformat(std::string_view Format, const Args & ... Arguments)
+{
+    std::string Result;
+    Result.reserve(Format.size() + sizeof...(Args) * 8);
+    vaformatappend(Result, Format, Arguments...);
+    return Result;
 }
@@ -0,0 +1,239 @@
+/*
+    Initial author: Convery (tcn@hedgehogscience.com)
+    Started: 19-10-2026
+    License: MIT
+    Notes:
+        Offline formatting of logs from Utility/Binarylog.
+        Usage: Logdecoder <Module.blog> [Output.log]
+*/
+
+#include <unordered_map>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <ctime>
+
+// On-disk layout, keep in sync with Source/Utility/Binarylog.hpp.
+enum Recordkind : uint8_t
+{
+    BL_FORMAT = 0,
+    BL_MESSAGE = 1,
+};
+struct Recordheader
+{
+    uint8_t Kind;
+    uint8_t Level;
+    uint16_t Argumentcount;
+    uint32_t Formatid;
+    uint32_t Threadid;
+    uint32_t Payloadsize;
+    uint64_t Timestamp;
+};
+static_assert(sizeof(Recordheader) == 24, "The logger writes a packed 24 byte header.");
+
+struct Argument_t
+{
+    uint8_t Kind;
+    uint64_t Word;
+    std::string String;
+};
+struct Message_t
+{
+    Recordheader Header;
+    std::vector<Argument_t> Arguments;
+};
+
+// Decode the arguments following a header.
+static bool Readarguments(const uint8_t *Pointer, const uint8_t *End, uint16_t Count, std::vector<Argument_t> &Arguments)
+{
+    for (uint16_t i = 0; i < Count; ++i)
+    {
+        Argument_t Argument{};
+        if (Pointer >= End) return false;
+        Argument.Kind = *Pointer++;
+
+        if (Argument.Kind == 's')
+        {
+            uint32_t Length;
+            if (Pointer + sizeof(uint32_t) > End) return false;
+            std::memcpy(&Length, Pointer, sizeof(uint32_t));
+            Pointer += sizeof(uint32_t);
+
+            if (Pointer + Length > End) return false;
+            Argument.String.assign((const char *)Pointer, Length);
+            Pointer += Length;
+        }
+        else
+        {
+            if (Pointer + sizeof(uint64_t) > End) return false;
+            std::memcpy(&Argument.Word, Pointer, sizeof(uint64_t));
+            Pointer += sizeof(uint64_t);
+        }
+
+        Arguments.push_back(std::move(Argument));
+    }
+
+    return true;
+}
+
+// Replay the printf-style format with the recorded arguments.
+static std::string Formatmessage(const std::string &Format, const std::vector<Argument_t> &Arguments)
+{
+    std::string Result;
+    size_t Argumentindex = 0;
+
+    auto Nextargument = [&]() -> const Argument_t *
+    {
+        static const Argument_t Missing{ 'u', 0, "" };
+        return Argumentindex < Arguments.size() ? &Arguments[Argumentindex++] : &Missing;
+    };
+
+    for (size_t i = 0; i < Format.size(); ++i)
+    {
+        if (Format[i] != '%') { Result += Format[i]; continue; }
+        if (i + 1 < Format.size() && Format[i + 1] == '%') { Result += '%'; ++i; continue; }
+
+        // Flags, width and precision are kept while length-modifiers are replaced.
+        std::string Specifier = "%";
+        int Starvalues[2]{}, Starcount = 0;
+        for (++i; i < Format.size(); ++i)
+        {
+            char Item = Format[i];
+            if (std::strchr("-+ #0123456789.", Item)) { Specifier += Item; continue; }
+            if (Item == '*') { Specifier += Item; if (Starcount < 2) Starvalues[Starcount++] = int(Nextargument()->Word); continue; }
+            if (std::strchr("hlLjzt", Item)) continue;
+            break;
+        }
+        if (i >= Format.size()) break;
+
+        char Conversion = Format[i];
+        const Argument_t *Argument = Nextargument();
+        auto Print = [&](const std::string &Localspecifier, auto Value)
+        {
+            auto Write = [&](char *Output, size_t Size)
+            {
+                if (Starcount == 2) return std::snprintf(Output, Size, Localspecifier.c_str(), Starvalues[0], Starvalues[1], Value);
+                if (Starcount == 1) return std::snprintf(Output, Size, Localspecifier.c_str(), Starvalues[0], Value);
+                return std::snprintf(Output, Size, Localspecifier.c_str(), Value);
+            };
+
+            // Measure first so long arguments are not truncated.
+            const int Length = Write(nullptr, 0);
+            if (Length <= 0) return;
+
+            const size_t Offset = Result.size();
+            Result.resize(Offset + Length + 1);
+            Write(&Result[Offset], Length + 1);
+            Result.resize(Offset + Length);
+        };
+
+        switch (Conversion)
+        {
+            case 'd': case 'i':
+                Print(Specifier + "lld", (long long)Argument->Word); break;
+            case 'u': case 'o': case 'x': case 'X':
+                Print(Specifier + "ll" + Conversion, (unsigned long long)Argument->Word); break;
+            case 'c':
+                Print(Specifier + "c", int(Argument->Word)); break;
+            case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+            {
+                double Float; std::memcpy(&Float, &Argument->Word, sizeof(double));
+                Print(Specifier + Conversion, Float); break;
+            }
+            case 's':
+                if (Argument->Kind == 's') Print(Specifier + "s", Argument->String.c_str());
+                else Print(Specifier + "s", "(null)");
+                break;
+            case 'p':
+                Print(std::string("0x%llx"), (unsigned long long)Argument->Word); break;
+
+            default: Result += Specifier + Conversion; break;
+        }
+    }
+
+    return Result;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        std::fprintf(stderr, "Usage: %s <Module.blog> [Output.log]\n", argv[0]);
+        return 1;
+    }
+
+    // Read the whole log into memory.
+    std::FILE *Filehandle = std::fopen(argv[1], "rb");
+    if (!Filehandle)
+    {
+        std::fprintf(stderr, "Could not open \"%s\"\n", argv[1]);
+        return 1;
+    }
+    std::fseek(Filehandle, 0, SEEK_END);
+    auto Length = std::ftell(Filehandle);
+    std::fseek(Filehandle, 0, SEEK_SET);
+    std::vector<uint8_t> Filebuffer(size_t(Length > 0 ? Length : 0));
+    if (!Filebuffer.empty()) std::fread(Filebuffer.data(), Filebuffer.size(), 1, Filehandle);
+    std::fclose(Filehandle);
+
+    // Collect the definitions and messages.
+    std::unordered_map<uint32_t, std::string> Formats;
+    std::vector<Message_t> Messages;
+    const uint8_t *Pointer = Filebuffer.data();
+    const uint8_t *End = Pointer + Filebuffer.size();
+
+    while (Pointer + sizeof(Recordheader) <= End)
+    {
+        Message_t Message{};
+        std::memcpy(&Message.Header, Pointer, sizeof(Recordheader));
+        Pointer += sizeof(Recordheader);
+
+        if (Pointer + Message.Header.Payloadsize > End)
+        {
+            std::fprintf(stderr, "Truncated record, stopping.\n");
+            break;
+        }
+
+        if (Message.Header.Kind == BL_FORMAT)
+        {
+            Formats[Message.Header.Formatid].assign((const char *)Pointer, Message.Header.Payloadsize);
+        }
+        else if (Message.Header.Kind == BL_MESSAGE)
+        {
+            if (!Readarguments(Pointer, Pointer + Message.Header.Payloadsize, Message.Header.Argumentcount, Message.Arguments))
+                std::fprintf(stderr, "Malformed arguments in record.\n");
+            Messages.push_back(std::move(Message));
+        }
+
+        Pointer += Message.Header.Payloadsize;
+    }
+
+    // Threads drain their buffers independently, so restore the global order.
+    std::stable_sort(Messages.begin(), Messages.end(), [](const Message_t &A, const Message_t &B)
+    {
+        return A.Header.Timestamp < B.Header.Timestamp;
+    });
+
+    // Formatted output, [Type][Time][Thread] Message
+    std::FILE *Output = argc > 2 ? std::fopen(argv[2], "w") : stdout;
+    if (!Output) Output = stdout;
+
+    for (auto &Message : Messages)
+    {
+        std::time_t Seconds = std::time_t(Message.Header.Timestamp / 1000000000);
+        char Timebuffer[80]{};
+        std::strftime(Timebuffer, 80, "%H:%M:%S", std::localtime(&Seconds));
+
+        auto Format = Formats.find(Message.Header.Formatid);
+        std::string Text = Format == Formats.end() ? "<unknown format>" : Formatmessage(Format->second, Message.Arguments);
+
+        std::fprintf(Output, "[%c][%s.%09llu][%u] %s\n", char(Message.Header.Level), Timebuffer,
+            (unsigned long long)(Message.Header.Timestamp % 1000000000), Message.Header.Threadid, Text.c_str());
+    }
+
+    if (Output != stdout) std::fclose(Output);
+    return 0;
+}